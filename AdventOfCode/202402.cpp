@@ -1,8 +1,13 @@
 #include <iostream>
 #include <fstream>
+#include <limits>
 #include <sstream>
 #include <vector>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 int main_01()
 {
 	// Open file, exit if something goes wrong.
@@ -113,8 +118,130 @@ bool IsRecordSafe_02(const std::vector<int>& vec, bool isOriginalLength = true)
 	return isSafe;
 }
 
+// Finds the first pair of adjacent levels (i, i + 1) that breaks the rules for the given direction.
+// Returns `count - 1` if every pair is fine.
+int FindFirstViolation_02(const int* levels, int count, bool isAscending)
+{
+	for (int i = 0; i < count - 1; ++i)
+	{
+		int diff = isAscending ? levels[i + 1] - levels[i] : levels[i] - levels[i + 1];
+		if (diff < 1 || diff > 3)
+			return i;
+	}
+	return count - 1;
+}
+
+// Checks the levels in the given direction as if the level at `skipIndex` wasn't there.
+bool IsSafeWithoutLevel_02(const int* levels, int count, bool isAscending, int skipIndex)
+{
+	int previous = -1; // index of the last level that wasn't skipped
+	for (int i = 0; i < count; ++i)
+	{
+		if (i == skipIndex)
+			continue;
+
+		if (previous >= 0)
+		{
+			int diff = isAscending ? levels[i] - levels[previous] : levels[previous] - levels[i];
+			if (diff < 1 || diff > 3)
+				return false;
+		}
+		previous = i;
+	}
+	return true;
+}
+
+// Same answer as `IsRecordSafe_02`, but without copying the report for every level.
+// If removing one level fixes the report, that level has to be one of the two levels
+// in the first bad pair (otherwise that pair would still be next to each other).
+// So only those two need to be tried, once for each direction.
+bool IsRecordSafeWithOneRemoval_02(const std::vector<int>& vec)
+{
+	const int count = static_cast<int>(vec.size());
+	const int* levels = vec.data();
+
+	for (bool isAscending : { true, false })
+	{
+		int violation = FindFirstViolation_02(levels, count, isAscending);
+		if (violation >= count - 1)
+			return true;
+
+		if (IsSafeWithoutLevel_02(levels, count, isAscending, violation) ||
+			IsSafeWithoutLevel_02(levels, count, isAscending, violation + 1))
+			return true;
+	}
+
+	return false;
+}
+
+// The most levels that `IsRecordSafeWithRemovals_02` can remove, so it can keep its state on the stack.
+constexpr int MAX_REMOVAL_TOLERANCE_02 = 15;
+
+// How many levels part 2 is allowed to remove from a report.
+constexpr int removalTolerance_02 = 1;
+
+// Checked once, up front, wherever a tolerance comes in, rather than for every report.
+bool IsValidRemovalTolerance_02(int tolerance)
+{
+	if (0 <= tolerance && tolerance <= MAX_REMOVAL_TOLERANCE_02)
+		return true;
+
+	printf("tolerance %d isn't supported, it has to be between 0 and %d\n", tolerance, MAX_REMOVAL_TOLERANCE_02);
+	return false;
+}
+
+// Checks if the report becomes safe after removing at most `tolerance` levels.
+//
+// removals[i] = the fewest levels to remove so that the kept levels up to (and including) i are safe.
+// The level kept right before i can't be more than `tolerance + 1` levels back, otherwise everything
+// in between would have to be removed too. So only the last `tolerance + 1` entries are ever looked at,
+// and they fit in a small ring buffer. That makes this O(n * tolerance) per direction.
+// `tolerance` has to pass `IsValidRemovalTolerance_02`.
+bool IsRecordSafeWithRemovals_02(const int* levels, int count, int tolerance)
+{
+	// Removing all levels but one always works.
+	if (count - 1 <= tolerance)
+		return true;
+
+	const int ringSize = tolerance + 2;
+	int removals[MAX_REMOVAL_TOLERANCE_02 + 2];
+
+	for (bool isAscending : { true, false })
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			// Worst case, remove everything before this level.
+			int best = i;
+
+			const int firstPrevious = i - tolerance - 1 > 0 ? i - tolerance - 1 : 0;
+			for (int j = firstPrevious; j < i; ++j)
+			{
+				int diff = isAscending ? levels[i] - levels[j] : levels[j] - levels[i];
+				if (diff < 1 || diff > 3)
+					continue;
+
+				// Keep j, remove everything between j and i.
+				int candidate = removals[j % ringSize] + (i - j - 1);
+				if (candidate < best)
+					best = candidate;
+			}
+
+			removals[i % ringSize] = best;
+
+			// Everything after i can be removed as well.
+			if (best + (count - 1 - i) <= tolerance)
+				return true;
+		}
+	}
+
+	return false;
+}
+
 int main_02()
 {
+	if (!IsValidRemovalTolerance_02(removalTolerance_02))
+		return -1;
+
 	// Open file, exit if something goes wrong.
 	std::ifstream file("input.txt", std::ios_base::in);
 	if (!file)
@@ -142,7 +269,12 @@ int main_02()
 			vec.emplace_back(level);
 		}
 
-		if (IsRecordSafe_02(vec))
+		// if (IsRecordSafe_02(vec))
+		bool isSafe = removalTolerance_02 == 1 ?
+			IsRecordSafeWithOneRemoval_02(vec) :
+			IsRecordSafeWithRemovals_02(vec.data(), static_cast<int>(vec.size()), removalTolerance_02);
+
+		if (isSafe)
 			++counter;
 	}
 
@@ -151,9 +283,319 @@ int main_02()
 	return 0;
 }
 
+// The longest report that fits in a batch. Longer reports get checked one at a time.
+constexpr int BATCH_LEVELS_01 = 16;
+
+// How many reports are checked together (one per 32-bit lane of an AVX2 register).
+constexpr int BATCH_REPORTS_01 = 8;
+
+// Fills the unused levels of a report in a batch.
+// Any pair ending on this value counts as safe in both directions.
+constexpr int PADDING_LEVEL_01 = std::numeric_limits<int>::min();
+
+// Level-major so that one row of the batch is one register: levels[l][r] is level l of report r.
+struct ReportBatch_01
+{
+	int levels[BATCH_LEVELS_01][BATCH_REPORTS_01];
+	int reportCount = 0;
+	int longestReport = 0;
+
+	ReportBatch_01() { Clear(); }
+
+	void Clear()
+	{
+		for (auto& row : levels)
+			for (int& level : row)
+				level = PADDING_LEVEL_01;
+		reportCount = 0;
+		longestReport = 0;
+	}
+
+	bool IsFull() const { return reportCount == BATCH_REPORTS_01; }
+
+	void Add(const std::vector<int>& vec)
+	{
+		for (int l = 0; l < static_cast<int>(vec.size()); ++l)
+			levels[l][reportCount] = vec[l];
+
+		if (static_cast<int>(vec.size()) > longestReport)
+			longestReport = static_cast<int>(vec.size());
+		++reportCount;
+	}
+};
+
+// Returns a bitmask with bit r set if report r of the batch is safe.
+unsigned FindSafeReportsInBatch_01(const ReportBatch_01& batch)
+{
+	unsigned safeMask = 0;
+
+#if defined(__AVX2__)
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i four = _mm256_set1_epi32(4);
+	const __m256i minusFour = _mm256_set1_epi32(-4);
+	const __m256i padding = _mm256_set1_epi32(PADDING_LEVEL_01);
+
+	__m256i allAscending = _mm256_set1_epi32(-1);
+	__m256i allDescending = _mm256_set1_epi32(-1);
+
+	__m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(batch.levels[0]));
+	for (int l = 1; l < batch.longestReport; ++l)
+	{
+		__m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(batch.levels[l]));
+		__m256i diff = _mm256_sub_epi32(next, current);
+		__m256i isPadding = _mm256_cmpeq_epi32(next, padding);
+
+		// 1 <= diff <= 3 is the same as 0 < diff < 4 (and the same goes for the negative side)
+		__m256i isAscending = _mm256_and_si256(_mm256_cmpgt_epi32(diff, zero), _mm256_cmpgt_epi32(four, diff));
+		__m256i isDescending = _mm256_and_si256(_mm256_cmpgt_epi32(zero, diff), _mm256_cmpgt_epi32(diff, minusFour));
+
+		allAscending = _mm256_and_si256(allAscending, _mm256_or_si256(isAscending, isPadding));
+		allDescending = _mm256_and_si256(allDescending, _mm256_or_si256(isDescending, isPadding));
+
+		current = next;
+	}
+
+	__m256i isSafe = _mm256_or_si256(allAscending, allDescending);
+	safeMask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(isSafe)));
+#else
+	for (int r = 0; r < BATCH_REPORTS_01; ++r)
+	{
+		bool allAscending = true;
+		bool allDescending = true;
+		for (int l = 1; l < batch.longestReport; ++l)
+		{
+			int next = batch.levels[l][r];
+			if (next == PADDING_LEVEL_01)
+				break;
+
+			int diff = next - batch.levels[l - 1][r];
+			allAscending &= 0 < diff && diff < 4;
+			allDescending &= -4 < diff && diff < 0;
+		}
+
+		if (allAscending || allDescending)
+			safeMask |= 1u << r;
+	}
+#endif
+
+	// Lanes past the last report are all padding, which would look safe.
+	return safeMask & ((1u << batch.reportCount) - 1);
+}
+
+int CountSafeReportsInBatch_01(const ReportBatch_01& batch)
+{
+	int count = 0;
+	for (unsigned mask = FindSafeReportsInBatch_01(batch); mask; mask &= mask - 1)
+		++count;
+	return count;
+}
+
+// Same as `main_01`, but the reports are checked 8 at a time.
+int main_01_batched()
+{
+	// Open file, exit if something goes wrong.
+	std::ifstream file("input.txt", std::ios_base::in);
+	if (!file)
+		return -1;
+
+	int counter = 0;
+	ReportBatch_01 batch;
+
+	// for every report in the file...
+	std::string report;
+	while (std::getline(file, report))
+	{
+		std::vector<int> vec;
+
+		// Store the report's numbers into a vector.
+		for (std::stringstream sstream(report); sstream;)
+		{
+			int level;
+			if (!(sstream >> level))
+				break;
+			vec.emplace_back(level);
+		}
+
+		// Skip blank lines.
+		if (vec.empty())
+			continue;
+
+		// Too long for a batch, check it on its own.
+		if (vec.size() > BATCH_LEVELS_01)
+		{
+			const int count = static_cast<int>(vec.size());
+			if (FindFirstViolation_02(vec.data(), count, true) == count - 1 ||
+				FindFirstViolation_02(vec.data(), count, false) == count - 1)
+				++counter;
+			continue;
+		}
+
+		batch.Add(vec);
+		if (batch.IsFull())
+		{
+			counter += CountSafeReportsInBatch_01(batch);
+			batch.Clear();
+		}
+	}
+
+	if (batch.reportCount > 0)
+		counter += CountSafeReportsInBatch_01(batch);
+
+	printf("counter: %d\n", counter);
+
+	file.close();
+
+	return 0;
+}
+
+// Classifies a report one level at a time, as the levels are being read.
+// Runs the same removal counting as `IsRecordSafeWithRemovals_02`, but since that only ever
+// looks `tolerance + 1` levels back, only that many levels need to be kept around.
+struct StreamingReportChecker_02
+{
+	static constexpr int RING_SIZE = MAX_REMOVAL_TOLERANCE_02 + 2;
+
+	int tolerance = 0;
+	int levelCount = 0;
+	int recentLevels[RING_SIZE] = { 0 };
+	int removals[2][RING_SIZE] = { { 0 } }; // [0] is for ascending, [1] is for descending
+
+	// `tolerance_` has to pass `IsValidRemovalTolerance_02`.
+	StreamingReportChecker_02(int tolerance_) : tolerance{ tolerance_ } {}
+
+	void AddLevel(int level)
+	{
+		const int ringSize = tolerance + 2;
+		const int i = levelCount;
+		const int firstPrevious = i - tolerance - 1 > 0 ? i - tolerance - 1 : 0;
+
+		for (int direction = 0; direction < 2; ++direction)
+		{
+			// Worst case, remove everything before this level.
+			int best = i;
+
+			for (int j = firstPrevious; j < i; ++j)
+			{
+				int previous = recentLevels[j % ringSize];
+				int diff = direction == 0 ? level - previous : previous - level;
+				if (diff < 1 || diff > 3)
+					continue;
+
+				int candidate = removals[direction][j % ringSize] + (i - j - 1);
+				if (candidate < best)
+					best = candidate;
+			}
+
+			removals[direction][i % ringSize] = best;
+		}
+
+		recentLevels[i % ringSize] = level;
+		++levelCount;
+	}
+
+	bool IsSafe() const
+	{
+		// Removing all levels but one always works.
+		if (levelCount - 1 <= tolerance)
+			return true;
+
+		const int ringSize = tolerance + 2;
+		for (int direction = 0; direction < 2; ++direction)
+		{
+			// Remove everything after the last kept level.
+			for (int i = levelCount - 1 - tolerance; i < levelCount; ++i)
+				if (removals[direction][i % ringSize] + (levelCount - 1 - i) <= tolerance)
+					return true;
+		}
+		return false;
+	}
+
+	void Reset() { levelCount = 0; }
+};
+
+// Parses and checks the reports in a single pass over the raw file contents.
+// No line, stream or vector is made per report, the only memory used is the read buffer.
+int CountSafeReportsFused(const char* filename, int tolerance)
+{
+	if (!IsValidRemovalTolerance_02(tolerance))
+		return -1;
+
+	std::ifstream file(filename, std::ios_base::in | std::ios_base::binary);
+	if (!file)
+		return -1;
+
+	static char buffer[1 << 16];
+
+	StreamingReportChecker_02 checker(tolerance);
+	int counter = 0;
+	int level = 0;
+	bool isInNumber = false;
+	bool isNegative = false;
+
+	auto FinishLevel = [&]
+		{
+			if (!isInNumber)
+				return;
+			checker.AddLevel(isNegative ? -level : level);
+			level = 0;
+			isInNumber = false;
+			isNegative = false;
+		};
+
+	auto FinishReport = [&]
+		{
+			FinishLevel();
+			if (checker.levelCount > 0 && checker.IsSafe()) // blank lines aren't reports
+				++counter;
+			checker.Reset();
+		};
+
+	while (file)
+	{
+		file.read(buffer, sizeof(buffer));
+		const std::streamsize bytesRead = file.gcount();
+
+		for (std::streamsize i = 0; i < bytesRead; ++i)
+		{
+			const char ch = buffer[i];
+			if ('0' <= ch && ch <= '9')
+			{
+				level = level * 10 + (ch - '0');
+				isInNumber = true;
+				continue;
+			}
+
+			FinishLevel();
+
+			if (ch == '\n')
+				FinishReport();
+			else if (ch == '-')
+				isNegative = true;
+		}
+	}
+
+	// The last report might not end with a newline.
+	FinishReport();
+
+	return counter;
+}
+
+int main_fused(int tolerance)
+{
+	int counter = CountSafeReportsFused("input.txt", tolerance);
+	if (counter < 0)
+		return -1;
+
+	printf("counter: %d\n", counter);
+	return 0;
+}
+
 int main()
 {
 	// main_01();
+	// main_01_batched();
+	// main_fused(0); // part 1
+	// main_fused(removalTolerance_02); // part 2
 	main_02();
 	return 0;
 }
@@ -197,7 +197,7 @@ struct NumberSequence : public Sequence
     }
 };
 
-int main_02()
+int main_02_sequences()
 {
     bool shouldMultiply = true;
 
@@ -231,9 +231,715 @@ int main_02()
     return 0;
 }
 
+#include <array>
+#include <atomic>
+#include <bit>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HAS_MMAP 1
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// States of the automaton in `InstructionScanner`.
+enum ScanState : unsigned char
+{
+    START,
+    M, MU, MUL, MUL_OPEN,
+    FIRST_1, FIRST_2, FIRST_3, COMMA,
+    SECOND_1, SECOND_2, SECOND_3, MUL_DONE,
+    D, DO, DO_OPEN, DO_DONE,
+    DON, DON_APOSTROPHE, DONT, DONT_OPEN, DONT_DONE,
+    SCAN_STATE_COUNT
+};
+
+// Only the characters used by the instructions get their own column, everything else is `OTHER`.
+enum ScanCharClass : unsigned char
+{
+    OTHER, CH_M, CH_U, CH_L, CH_D, CH_O, CH_N, CH_T, CH_APOSTROPHE,
+    CH_OPEN, CH_CLOSE, CH_COMMA, CH_DIGIT,
+    SCAN_CLASS_COUNT
+};
+
+using ScanClassTable = std::array<unsigned char, 256>;
+using ScanTransitionTable = std::array<std::array<unsigned char, SCAN_CLASS_COUNT>, SCAN_STATE_COUNT>;
+
+constexpr ScanClassTable MakeScanClassTable()
+{
+    ScanClassTable table{};
+    table['m'] = CH_M;
+    table['u'] = CH_U;
+    table['l'] = CH_L;
+    table['d'] = CH_D;
+    table['o'] = CH_O;
+    table['n'] = CH_N;
+    table['t'] = CH_T;
+    table['\''] = CH_APOSTROPHE;
+    table['('] = CH_OPEN;
+    table[')'] = CH_CLOSE;
+    table[','] = CH_COMMA;
+    for (char ch = '0'; ch <= '9'; ++ch)
+        table[static_cast<unsigned char>(ch)] = CH_DIGIT;
+    return table;
+}
+
+constexpr ScanTransitionTable MakeScanTransitionTable()
+{
+    ScanTransitionTable table{};
+
+    // A character that doesn't continue the current instruction might still start a new one,
+    // so every state falls back to what START would do.
+    for (auto& row : table)
+    {
+        row.fill(START);
+        row[CH_M] = M;
+        row[CH_D] = D;
+    }
+
+    table[M][CH_U] = MU;
+    table[MU][CH_L] = MUL;
+    table[MUL][CH_OPEN] = MUL_OPEN;
+    table[MUL_OPEN][CH_DIGIT] = FIRST_1;
+    table[FIRST_1][CH_DIGIT] = FIRST_2;
+    table[FIRST_2][CH_DIGIT] = FIRST_3;
+    table[FIRST_1][CH_COMMA] = COMMA;
+    table[FIRST_2][CH_COMMA] = COMMA;
+    table[FIRST_3][CH_COMMA] = COMMA;
+    table[COMMA][CH_DIGIT] = SECOND_1;
+    table[SECOND_1][CH_DIGIT] = SECOND_2;
+    table[SECOND_2][CH_DIGIT] = SECOND_3;
+    table[SECOND_1][CH_CLOSE] = MUL_DONE;
+    table[SECOND_2][CH_CLOSE] = MUL_DONE;
+    table[SECOND_3][CH_CLOSE] = MUL_DONE;
+
+    table[D][CH_O] = DO;
+    table[DO][CH_OPEN] = DO_OPEN;
+    table[DO_OPEN][CH_CLOSE] = DO_DONE;
+    table[DO][CH_N] = DON;
+    table[DON][CH_APOSTROPHE] = DON_APOSTROPHE;
+    table[DON_APOSTROPHE][CH_T] = DONT;
+    table[DONT][CH_OPEN] = DONT_OPEN;
+    table[DONT_OPEN][CH_CLOSE] = DONT_DONE;
+
+    return table;
+}
+
+constexpr ScanClassTable scanClasses = MakeScanClassTable();
+constexpr ScanTransitionTable scanTransitions = MakeScanTransitionTable();
+
+// Every instruction starts with 'm' or 'd', so while the automaton is in START
+// everything up to the next one of those can be skipped.
+// Returns the index of the first 'm' or 'd' at or after `pos`, or `size` if there isn't one.
+size_t FindNextCandidate(const char* data, size_t pos, size_t size)
+{
+#if defined(__AVX2__)
+    const __m256i m = _mm256_set1_epi8('m');
+    const __m256i d = _mm256_set1_epi8('d');
+    for (; pos + 32 <= size; pos += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i isCandidate = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, m), _mm256_cmpeq_epi8(chunk, d));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(isCandidate));
+        if (mask)
+            return pos + std::countr_zero(mask);
+    }
+#elif defined(__SSE2__)
+    const __m128i m = _mm_set1_epi8('m');
+    const __m128i d = _mm_set1_epi8('d');
+    for (; pos + 16 <= size; pos += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i isCandidate = _mm_or_si128(_mm_cmpeq_epi8(chunk, m), _mm_cmpeq_epi8(chunk, d));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(isCandidate));
+        if (mask)
+            return pos + std::countr_zero(mask);
+    }
+#endif
+
+    // whatever is left over (or everything, without SIMD)
+    for (; pos < size; ++pos)
+        if (data[pos] == 'm' || data[pos] == 'd')
+            return pos;
+    return size;
+}
+
+// Recognises `mul(a,b)`, `do()` and `don't()` all at once with a single deterministic automaton.
+// Every byte it looks at is one lookup in `scanTransitions`, and the numbers are collected right in `Step`.
+struct InstructionScanner
+{
+    unsigned char state = START;
+    int firstNumber = 0;
+    int secondNumber = 0;
+    bool shouldMultiply = true;
+    long long total = 0;
+
+    // When false, `do()` and `don't()` are ignored (part 1).
+    bool useConditionals = true;
+
+    // Used to summarise chunks: what `total` was when the first `do()`/`don't()` showed up.
+    bool sawToggle = false;
+    long long totalBeforeToggle = 0;
+
+    void Toggle(bool enable)
+    {
+        if (!sawToggle)
+        {
+            sawToggle = true;
+            totalBeforeToggle = total;
+        }
+        shouldMultiply = enable;
+    }
+
+    void Step(unsigned char ch)
+    {
+        state = scanTransitions[state][scanClasses[ch]];
+
+        switch (state)
+        {
+        case FIRST_1:  firstNumber = ch - '0'; break;
+        case FIRST_2:
+        case FIRST_3:  firstNumber = firstNumber * 10 + (ch - '0'); break;
+        case SECOND_1: secondNumber = ch - '0'; break;
+        case SECOND_2:
+        case SECOND_3: secondNumber = secondNumber * 10 + (ch - '0'); break;
+        case MUL_DONE:
+            if (shouldMultiply || !useConditionals)
+                total += firstNumber * secondNumber;
+            state = START;
+            break;
+        case DO_DONE:   Toggle(true);  state = START; break;
+        case DONT_DONE: Toggle(false); state = START; break;
+        default: break;
+        }
+    }
+
+    void Feed(const char* data, size_t size)
+    {
+        size_t i = 0;
+        while (i < size)
+        {
+            // Nothing is in progress, so jump straight to where the next instruction could start.
+            if (state == START)
+            {
+                i = FindNextCandidate(data, i, size);
+                if (i >= size)
+                    break;
+            }
+
+            Step(static_cast<unsigned char>(data[i]));
+            ++i;
+        }
+    }
+
+    // Keeps going only until the instruction in progress (if any) is done or broken.
+    // An 'm' or 'd' always starts a new instruction, so the scan stops there too.
+    void FinishPending(const char* data, size_t size)
+    {
+        for (size_t i = 0; i < size && state != START; ++i)
+        {
+            if (data[i] == 'm' || data[i] == 'd')
+            {
+                state = START;
+                break;
+            }
+            Step(static_cast<unsigned char>(data[i]));
+        }
+    }
+};
+
+// What a chunk of memory adds to the total, for both possible values of the enable flag at its start.
+// Everything after the first `do()`/`don't()` in a chunk doesn't depend on how the chunk started.
+struct ChunkSummary
+{
+    long long totalIfEnabled = 0;
+    long long totalIfDisabled = 0;
+    bool hasToggle = false;
+    bool endsEnabled = false; // only meaningful if `hasToggle`
+
+    bool EndState(bool startsEnabled) const { return hasToggle ? endsEnabled : startsEnabled; }
+};
+
+// Summary of chunk `a` followed by chunk `b`. Associative, so the chunks can be summarised in any order.
+ChunkSummary Combine(const ChunkSummary& a, const ChunkSummary& b)
+{
+    ChunkSummary result;
+    result.totalIfEnabled = a.totalIfEnabled + (a.EndState(true) ? b.totalIfEnabled : b.totalIfDisabled);
+    result.totalIfDisabled = a.totalIfDisabled + (a.EndState(false) ? b.totalIfEnabled : b.totalIfDisabled);
+    result.hasToggle = a.hasToggle || b.hasToggle;
+    result.endsEnabled = b.hasToggle ? b.endsEnabled : a.endsEnabled;
+    return result;
+}
+
+// Only instructions that *start* in [begin, end) are counted. The scan runs past `end`
+// just far enough to finish one that started inside, and a fresh scanner at `begin`
+// can't pick up one that started before it, since those never contain an 'm' or 'd'.
+ChunkSummary SummariseChunk(const char* data, size_t size, size_t begin, size_t end, bool useConditionals)
+{
+    InstructionScanner scanner;
+    scanner.useConditionals = useConditionals;
+    scanner.Feed(data + begin, end - begin);
+    scanner.FinishPending(data + end, size - end);
+
+    ChunkSummary summary;
+    summary.totalIfEnabled = scanner.total;
+    summary.totalIfDisabled = scanner.sawToggle ? scanner.total - scanner.totalBeforeToggle : 0;
+    summary.hasToggle = scanner.sawToggle;
+    summary.endsEnabled = scanner.shouldMultiply;
+
+    if (!useConditionals)
+    {
+        summary.totalIfDisabled = summary.totalIfEnabled;
+        summary.hasToggle = false;
+    }
+
+    return summary;
+}
+
+long long ScanInParallel(const char* data, size_t size, bool useConditionals, size_t chunkSize = 1 << 20)
+{
+    const size_t chunkCount = (size + chunkSize - 1) / chunkSize;
+    std::vector<ChunkSummary> summaries(chunkCount);
+
+    unsigned threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0)
+        threadCount = 1;
+    if (threadCount > chunkCount)
+        threadCount = static_cast<unsigned>(chunkCount);
+
+    // Each worker keeps grabbing the next chunk that nobody has taken yet.
+    std::atomic<size_t> nextChunk = 0;
+    auto Work = [&]
+        {
+            for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++)
+            {
+                size_t begin = chunk * chunkSize;
+                size_t end = begin + chunkSize < size ? begin + chunkSize : size;
+                summaries[chunk] = SummariseChunk(data, size, begin, end, useConditionals);
+            }
+        };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threadCount; ++i)
+        workers.emplace_back(Work);
+    for (std::thread& worker : workers)
+        worker.join();
+
+    ChunkSummary combined;
+    for (const ChunkSummary& summary : summaries)
+        combined = Combine(combined, summary);
+
+    // The memory starts off with multiplications enabled.
+    return combined.totalIfEnabled;
+}
+
+// Read-only view of a whole file. Uses mmap where it's available, otherwise just reads the file in.
+struct MappedFile
+{
+    const char* data = nullptr;
+    size_t size = 0;
+
+#if HAS_MMAP
+    void* mapping = nullptr;
+#endif
+    std::string contents;
+
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const char* filename)
+    {
+#if HAS_MMAP
+        int fd = open(filename, O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0)
+        {
+            close(fd);
+            return false;
+        }
+
+        size = static_cast<size_t>(info.st_size);
+        if (size > 0)
+        {
+            mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED)
+            {
+                mapping = nullptr;
+                close(fd);
+                return false;
+            }
+            data = static_cast<const char*>(mapping);
+        }
+
+        close(fd);
+        return true;
+#else
+        std::ifstream file(filename, std::ios_base::in | std::ios_base::binary);
+        if (!file)
+            return false;
+
+        contents.assign(std::istreambuf_iterator<char>{file}, {});
+        data = contents.data();
+        size = contents.size();
+        return true;
+#endif
+    }
+
+    ~MappedFile()
+    {
+#if HAS_MMAP
+        if (mapping)
+            munmap(mapping, size);
+#endif
+    }
+};
+
+bool ReadFileContents(const char* filename, std::string& contents)
+{
+    std::ifstream file(filename, std::ios_base::in | std::ios_base::binary);
+    if (!file)
+        return false;
+
+    contents.assign(std::istreambuf_iterator<char>{file}, {});
+    return true;
+}
+
+int main_01_scanner()
+{
+    std::string contents;
+    if (!ReadFileContents("input.txt", contents))
+        return -1;
+
+    InstructionScanner scanner;
+    scanner.useConditionals = false;
+    scanner.Feed(contents.data(), contents.size());
+
+    printf("Grand total: %lld\n", scanner.total);
+
+    return 0;
+}
+
+int main_02()
+{
+    std::string contents;
+    if (!ReadFileContents("input.txt", contents))
+        return -1;
+
+    InstructionScanner scanner;
+    scanner.Feed(contents.data(), contents.size());
+
+    printf("total: %lld\n", scanner.total);
+
+    return 0;
+}
+
+// A string literal that can be passed as a template argument, e.g. `Lit<"mul(">`.
+template <size_t N>
+struct FixedString
+{
+    char chars[N] = {};
+
+    constexpr FixedString(const char (&str)[N])
+    {
+        for (size_t i = 0; i < N; ++i)
+            chars[i] = str[i];
+    }
+
+    constexpr size_t Length() const { return N - 1; }
+};
+
+// Pattern part that matches exactly `text`.
+template <FixedString text>
+struct Lit
+{
+    static constexpr int captureCount = 0;
+
+    static constexpr bool CanStartWith(unsigned char ch) { return ch == static_cast<unsigned char>(text.chars[0]); }
+
+    static constexpr bool Match(const char* data, size_t size, size_t& pos, int*&)
+    {
+        constexpr size_t length = text.Length();
+        if (size - pos < length)
+            return false;
+
+        for (size_t i = 0; i < length; ++i)
+            if (data[pos + i] != text.chars[i])
+                return false;
+
+        pos += length;
+        return true;
+    }
+};
+
+// Pattern part that matches a number with `minDigits` to `maxDigits` digits, and stores it in the next capture.
+template <int minDigits, int maxDigits>
+struct Num
+{
+    static_assert(0 < minDigits && minDigits <= maxDigits && maxDigits <= 9, "the number has to fit in an int");
+
+    static constexpr int captureCount = 1;
+
+    static constexpr bool CanStartWith(unsigned char ch) { return '0' <= ch && ch <= '9'; }
+
+    static constexpr bool Match(const char* data, size_t size, size_t& pos, int*& capture)
+    {
+        int value = 0;
+        int digits = 0;
+        while (digits < maxDigits && pos + digits < size && CanStartWith(static_cast<unsigned char>(data[pos + digits])))
+        {
+            value = value * 10 + (data[pos + digits] - '0');
+            ++digits;
+        }
+
+        if (digits < minDigits)
+            return false;
+
+        *capture++ = value;
+        pos += digits;
+        return true;
+    }
+};
+
+// A whole instruction, e.g. `Pattern<Lit<"mul(">, Num<1, 3>, Lit<",">, Num<1, 3>, Lit<")">>`.
+// Replaces the runtime `stages` + `USE_NUMBERS` approach of `Sequence`: the parts are chained
+// together at compile time, so each pattern ends up as its own straight-line matcher.
+template <typename... Parts>
+struct Pattern
+{
+    static constexpr int captureCount = (Parts::captureCount + ... + 0);
+    using Captures = std::array<int, captureCount>;
+
+    static constexpr bool CanStartWith(unsigned char ch)
+    {
+        return std::tuple_element_t<0, std::tuple<Parts...>>::CanStartWith(ch);
+    }
+
+    // On a match, `pos` is moved to just after it. Otherwise it's left alone.
+    static constexpr bool Match(const char* data, size_t size, size_t& pos, Captures& captures)
+    {
+        size_t cursor = pos;
+        int* capture = captures.data();
+        if (!(Parts::Match(data, size, cursor, capture) && ...))
+            return false;
+
+        pos = cursor;
+        return true;
+    }
+};
+
+struct PatternScanState
+{
+    long long total = 0;
+    bool shouldMultiply = true;
+    bool useConditionals = true;
+};
+
+// Each instruction is a grammar plus what to do when it's found.
+// Adding a new kind of instruction is just another one of these passed to `ScanWithPatterns`.
+struct MulInstruction
+{
+    using Grammar = Pattern<Lit<"mul(">, Num<1, 3>, Lit<",">, Num<1, 3>, Lit<")">>;
+
+    static void Apply(PatternScanState& state, const Grammar::Captures& numbers)
+    {
+        if (state.shouldMultiply || !state.useConditionals)
+            state.total += numbers[0] * numbers[1];
+    }
+};
+
+struct DoInstruction
+{
+    using Grammar = Pattern<Lit<"do()">>;
+
+    static void Apply(PatternScanState& state, const Grammar::Captures&) { state.shouldMultiply = true; }
+};
+
+struct DontInstruction
+{
+    using Grammar = Pattern<Lit<"don't()">>;
+
+    static void Apply(PatternScanState& state, const Grammar::Captures&) { state.shouldMultiply = false; }
+};
+
+// Characters that could start any of the instructions, so everything else can be skipped.
+template <typename... Instructions>
+constexpr std::array<bool, 256> patternCandidates = []
+    {
+        std::array<bool, 256> table{};
+        for (unsigned ch = 0; ch < 256; ++ch)
+            table[ch] = (Instructions::Grammar::CanStartWith(static_cast<unsigned char>(ch)) || ...);
+        return table;
+    }();
+
+template <typename Instruction>
+bool TryInstruction(const char* data, size_t size, size_t& pos, PatternScanState& state)
+{
+    typename Instruction::Grammar::Captures captures{};
+    if (!Instruction::Grammar::Match(data, size, pos, captures))
+        return false;
+
+    Instruction::Apply(state, captures);
+    return true;
+}
+
+template <typename... Instructions>
+void ScanWithPatterns(const char* data, size_t size, PatternScanState& state)
+{
+    size_t pos = 0;
+    while (pos < size)
+    {
+        if (!patternCandidates<Instructions...>[static_cast<unsigned char>(data[pos])])
+        {
+            ++pos;
+            continue;
+        }
+
+        // The first instruction that matches wins, and the scan carries on right after it.
+        if (!(TryInstruction<Instructions>(data, size, pos, state) || ...))
+            ++pos;
+    }
+}
+
+int main_02_patterns()
+{
+    std::string contents;
+    if (!ReadFileContents("input.txt", contents))
+        return -1;
+
+    PatternScanState state;
+    ScanWithPatterns<MulInstruction, DoInstruction, DontInstruction>(contents.data(), contents.size(), state);
+
+    printf("total: %lld\n", state.total);
+
+    return 0;
+}
+
+int main_parallel(bool useConditionals)
+{
+    MappedFile file;
+    if (!file.Open("input.txt"))
+        return -1;
+
+    printf("total: %lld\n", ScanInParallel(file.data, file.size, useConditionals));
+
+    return 0;
+}
+
+// Everything needed to carry on scanning a file that has grown since the last run.
+// The automaton state and any half-read numbers are saved too, so an instruction that was
+// cut off at the old end of the file still gets finished.
+struct ScanProgress
+{
+    unsigned long long offset = 0;
+    InstructionScanner scanner;
+
+    bool Load(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (!file)
+            return false;
+
+        int state, shouldMultiply, useConditionals;
+        file >> offset >> state >> scanner.firstNumber >> scanner.secondNumber
+            >> shouldMultiply >> useConditionals >> scanner.total;
+        if (!file || state < 0 || state >= SCAN_STATE_COUNT)
+            return false;
+
+        scanner.state = static_cast<unsigned char>(state);
+        scanner.shouldMultiply = shouldMultiply != 0;
+        scanner.useConditionals = useConditionals != 0;
+        return true;
+    }
+
+    bool Save(const std::string& path) const
+    {
+        std::ofstream file(path, std::ios_base::out | std::ios_base::trunc);
+        if (!file)
+            return false;
+
+        file << offset << ' ' << static_cast<int>(scanner.state) << ' '
+            << scanner.firstNumber << ' ' << scanner.secondNumber << ' '
+            << scanner.shouldMultiply << ' ' << scanner.useConditionals << ' '
+            << scanner.total << '\n';
+        return static_cast<bool>(file);
+    }
+};
+
+// Scans only what was appended to `filename` since the last call, picking up from `<filename>.state`.
+// Starts over if there's no saved progress, it was for the other part, or the file got shorter.
+bool FollowFile(const char* filename, bool useConditionals, long long& total)
+{
+    const std::string progressPath = std::string(filename) + ".state";
+
+    std::ifstream file(filename, std::ios_base::in | std::ios_base::binary);
+    if (!file)
+        return false;
+
+    file.seekg(0, std::ios_base::end);
+    const unsigned long long fileSize = static_cast<unsigned long long>(file.tellg());
+
+    ScanProgress progress;
+    if (!progress.Load(progressPath) || progress.scanner.useConditionals != useConditionals || progress.offset > fileSize)
+    {
+        progress = ScanProgress{};
+        progress.scanner.useConditionals = useConditionals;
+    }
+
+    file.seekg(static_cast<std::streamoff>(progress.offset));
+
+    static char buffer[1 << 16];
+    while (file)
+    {
+        file.read(buffer, sizeof(buffer));
+        const std::streamsize bytesRead = file.gcount();
+        progress.scanner.Feed(buffer, static_cast<size_t>(bytesRead));
+        progress.offset += static_cast<unsigned long long>(bytesRead);
+    }
+
+    if (!progress.Save(progressPath))
+        printf("couldn't save progress to %s\n", progressPath.c_str());
+
+    total = progress.scanner.total;
+    return true;
+}
+
+int main_follow(bool useConditionals)
+{
+    long long total = 0;
+    if (!FollowFile("input.txt", useConditionals, total))
+        return -1;
+
+    printf("total: %lld\n", total);
+
+    return 0;
+}
+
 int main()
 {
     // main_01();
+    // main_01_scanner();
+    // main_parallel(false); // part 1
+    // main_parallel(true); // part 2
+    // main_follow(false); // part 1
+    // main_follow(true); // part 2
+    // main_02_sequences();
+    // main_02_patterns();
     main_02();
     return 0;
 }
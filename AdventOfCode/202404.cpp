@@ -1,9 +1,19 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
 #include <iostream>
 #include <fstream>
 #include <functional>
 #include <string>
 #include <vector>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #define PRINT(x) std::cout << #x << ": " << (x) << "\n"
 
 struct Direction
@@ -321,8 +331,649 @@ int main_02(int argc, char* argv[])
 	return 0;
 }
 
+using Grid = std::vector<std::string>;
+
+bool ReadDataFromFile(const char* filename, Grid& grid)
+{
+	std::fstream file(filename);
+	if (!file)
+	{
+		printf("sorry %s isn't a file\n", filename);
+		return false;
+	}
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		while (!line.empty() && !isalpha(line.back()))
+			line.pop_back();
+
+		if (!line.empty())
+			grid.emplace_back(line);
+	}
+
+	return true;
+}
+
+// One bitmask per letter per row: bit `col` of row `row` in plane `p` is set if grid[row][col] == letters[p].
+// Rows don't have to be the same length (or the same as the number of rows).
+struct Bitboard
+{
+	using Word = std::uint64_t;
+	constexpr static int WORD_BITS = 64;
+
+	int width = 0;
+	int height = 0;
+	int wordsPerRow = 0;
+	int planeCount = 0;
+	std::vector<Word> bits;
+
+	Bitboard(const Grid& grid, const std::string& letters)
+	{
+		height = static_cast<int>(grid.size());
+		for (const std::string& row : grid)
+			width = std::max(width, static_cast<int>(row.size()));
+		wordsPerRow = (width + WORD_BITS - 1) / WORD_BITS;
+		planeCount = static_cast<int>(letters.size());
+
+		bits.assign(static_cast<size_t>(planeCount) * height * wordsPerRow, 0);
+		for (int plane = 0; plane < planeCount; ++plane)
+			for (int row = 0; row < height; ++row)
+				for (int col = 0; col < static_cast<int>(grid[row].size()); ++col)
+					if (grid[row][col] == letters[plane])
+						Row(plane, row)[col / WORD_BITS] |= Word{ 1 } << (col % WORD_BITS);
+	}
+
+	Word* Row(int plane, int row) { return &bits[(static_cast<size_t>(plane) * height + row) * wordsPerRow]; }
+	const Word* Row(int plane, int row) const { return &bits[(static_cast<size_t>(plane) * height + row) * wordsPerRow]; }
+
+	// Word `word` of a row, moved so that bit `col` lines up with what was at column `col + offset`.
+	// Anything that moves in from outside the row is 0. `offset` has to be smaller than 64 either way.
+	Word Shifted(int plane, int row, int word, int offset) const
+	{
+		const Word* bitsInRow = Row(plane, row);
+		if (offset == 0)
+			return bitsInRow[word];
+
+		if (offset > 0)
+		{
+			Word result = bitsInRow[word] >> offset;
+			if (word + 1 < wordsPerRow)
+				result |= bitsInRow[word + 1] << (WORD_BITS - offset);
+			return result;
+		}
+
+		Word result = bitsInRow[word] << -offset;
+		if (word > 0)
+			result |= bitsInRow[word - 1] >> (WORD_BITS + offset);
+		return result;
+	}
+};
+
+// Counts `word` in all eight directions, 64 cells at a time.
+// For a direction (dRow, dCol), a match starts wherever the first letter's bit is set AND
+// the k-th letter's bit is set k steps further along, which is just the k-th plane from
+// row + k * dRow, shifted by k * dCol.
+int CountWordBitboard(const Grid& grid, const std::string& word)
+{
+	const Bitboard board(grid, word);
+	const int length = static_cast<int>(word.size());
+	if (length == 0 || length > Bitboard::WORD_BITS)
+		return 0;
+
+	const int directions[Direction::dirsSize][2] = {
+		{ -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 },
+		{ -1, -1 }, { -1, 1 }, { 1, -1 }, { 1, 1 }
+	};
+
+	int total = 0;
+	for (const auto& [dRow, dCol] : directions)
+	{
+		// A single letter reads the same in every direction, so only count it once.
+		if (length == 1 && (dRow != -1 || dCol != 0))
+			break;
+
+		for (int row = 0; row < board.height; ++row)
+		{
+			const int lastRow = row + (length - 1) * dRow;
+			if (lastRow < 0 || lastRow >= board.height)
+				continue;
+
+			for (int w = 0; w < board.wordsPerRow; ++w)
+			{
+				Bitboard::Word matches = board.Row(0, row)[w];
+				for (int k = 1; k < length && matches; ++k)
+					matches &= board.Shifted(k, row + k * dRow, w, k * dCol);
+
+				total += std::popcount(matches);
+			}
+		}
+	}
+
+	return total;
+}
+
+// Counts the 'A's that are in the middle of two diagonal "MAS"es (forwards or backwards).
+int CountCrossBitboard(const Grid& grid)
+{
+	enum { M, A, S };
+	const Bitboard board(grid, "MAS");
+
+	int total = 0;
+	for (int row = 1; row + 1 < board.height; ++row)
+	{
+		for (int w = 0; w < board.wordsPerRow; ++w)
+		{
+			Bitboard::Word northWestM = board.Shifted(M, row - 1, w, -1);
+			Bitboard::Word northWestS = board.Shifted(S, row - 1, w, -1);
+			Bitboard::Word northEastM = board.Shifted(M, row - 1, w, 1);
+			Bitboard::Word northEastS = board.Shifted(S, row - 1, w, 1);
+			Bitboard::Word southWestM = board.Shifted(M, row + 1, w, -1);
+			Bitboard::Word southWestS = board.Shifted(S, row + 1, w, -1);
+			Bitboard::Word southEastM = board.Shifted(M, row + 1, w, 1);
+			Bitboard::Word southEastS = board.Shifted(S, row + 1, w, 1);
+
+			Bitboard::Word backslash = (northWestM & southEastS) | (northWestS & southEastM);
+			Bitboard::Word slash = (northEastM & southWestS) | (northEastS & southWestM);
+
+			total += std::popcount(board.Row(A, row)[w] & backslash & slash);
+		}
+	}
+
+	return total;
+}
+
+enum class GridLineFamily { ROWS, COLUMNS, DIAGONALS, ANTI_DIAGONALS };
+
+// Calls `callback(family, startRow, startCol, dRow, dCol)` once for every row, column, diagonal
+// (going down-right) and anti-diagonal (going down-left) of a `height` by `width` grid.
+template <typename Callback>
+void ForEachGridLine(int height, int width, Callback callback)
+{
+	for (int row = 0; row < height; ++row)
+		callback(GridLineFamily::ROWS, row, 0, 0, 1);
+
+	for (int col = 0; col < width; ++col)
+		callback(GridLineFamily::COLUMNS, 0, col, 1, 0);
+
+	for (int col = 0; col < width; ++col)
+		callback(GridLineFamily::DIAGONALS, 0, col, 1, 1);
+	for (int row = 1; row < height; ++row)
+		callback(GridLineFamily::DIAGONALS, row, 0, 1, 1);
+
+	for (int col = 0; col < width; ++col)
+		callback(GridLineFamily::ANTI_DIAGONALS, 0, col, 1, -1);
+	for (int row = 1; row < height; ++row)
+		callback(GridLineFamily::ANTI_DIAGONALS, row, width - 1, 1, -1);
+}
+
+// Aho-Corasick automaton over a list of words and their reverses.
+// Running it forwards along a line finds every word written in that direction (the word itself)
+// and in the opposite direction (its reverse), so each line only has to be walked once.
+struct WordAutomaton
+{
+	std::vector<std::string> words;
+
+	// Letters used by the words get their own column, 0 is for everything else.
+	std::array<int, 256> alphabet{};
+	int alphabetSize = 1;
+
+	std::vector<int> transitions; // transitions[node * alphabetSize + letter]
+	std::vector<int> fail;
+	std::vector<int> breadthFirstOrder;
+
+	// The nodes where each word and its reverse end (the same node twice for palindromes).
+	std::vector<std::array<int, 2>> wordNodes;
+
+	// How many times each node was reached during the scans.
+	std::vector<long long> hits;
+
+	WordAutomaton(const std::vector<std::string>& words_) : words{ words_ }
+	{
+		for (const std::string& word : words)
+			for (char ch : word)
+				if (alphabet[static_cast<unsigned char>(ch)] == 0)
+					alphabet[static_cast<unsigned char>(ch)] = alphabetSize++;
+
+		AddNode(); // root
+
+		for (const std::string& word : words)
+		{
+			std::string reversed(word.rbegin(), word.rend());
+			wordNodes.push_back({ Insert(word), Insert(reversed) });
+		}
+
+		Link();
+		hits.assign(fail.size(), 0);
+	}
+
+	int AddNode()
+	{
+		transitions.insert(transitions.end(), alphabetSize, -1);
+		fail.emplace_back(0);
+		return static_cast<int>(fail.size()) - 1;
+	}
+
+	int Insert(const std::string& word)
+	{
+		int node = 0;
+		for (char ch : word)
+		{
+			int letter = alphabet[static_cast<unsigned char>(ch)];
+			if (transitions[node * alphabetSize + letter] < 0)
+			{
+				int child = AddNode(); // can reallocate `transitions`, so don't hold on to a reference
+				transitions[node * alphabetSize + letter] = child;
+			}
+			node = transitions[node * alphabetSize + letter];
+		}
+		return node;
+	}
+
+	// Fills in the fail links, and turns the trie into a full DFA so scanning never has to follow them.
+	void Link()
+	{
+		for (int letter = 0; letter < alphabetSize; ++letter)
+		{
+			int& next = transitions[letter];
+			if (letter == 0 || next < 0)
+				next = 0;
+			else
+				breadthFirstOrder.emplace_back(next);
+		}
+
+		for (size_t i = 0; i < breadthFirstOrder.size(); ++i)
+		{
+			int node = breadthFirstOrder[i];
+			transitions[node * alphabetSize] = 0; // not a letter in any word
+
+			for (int letter = 1; letter < alphabetSize; ++letter)
+			{
+				int& next = transitions[node * alphabetSize + letter];
+				int fallback = transitions[fail[node] * alphabetSize + letter];
+				if (next < 0)
+				{
+					next = fallback;
+				}
+				else
+				{
+					fail[next] = fallback;
+					breadthFirstOrder.emplace_back(next);
+				}
+			}
+		}
+	}
+
+	// Call once at the start of every line.
+	int Start() const { return 0; }
+
+	int Step(int node, char ch)
+	{
+		node = transitions[node * alphabetSize + alphabet[static_cast<unsigned char>(ch)]];
+		++hits[node];
+		return node;
+	}
+
+	// Every time a node was reached, each shorter word ending there (found through its fail links) was seen too.
+	// Pushing the counts down the fail links deepest-first adds those in without walking the links per character.
+	std::vector<long long> CountWords()
+	{
+		std::vector<long long> totals = hits;
+		for (auto it = breadthFirstOrder.rbegin(); it != breadthFirstOrder.rend(); ++it)
+			totals[fail[*it]] += totals[*it];
+
+		std::vector<long long> counts(words.size(), 0);
+		for (size_t i = 0; i < words.size(); ++i)
+			counts[i] = totals[wordNodes[i][0]] + totals[wordNodes[i][1]];
+		return counts;
+	}
+};
+
+// Counts every word in all eight directions with one pass of the automaton over each
+// row, column, diagonal and anti-diagonal. Single letters are counted once per cell.
+std::vector<long long> CountWordsDictionary(const Grid& grid, const std::vector<std::string>& words)
+{
+	std::vector<std::string> longWords;
+	std::vector<int> longWordIndices;
+	for (size_t i = 0; i < words.size(); ++i)
+	{
+		if (words[i].size() >= 2)
+		{
+			longWords.emplace_back(words[i]);
+			longWordIndices.emplace_back(static_cast<int>(i));
+		}
+	}
+
+	WordAutomaton automaton(longWords);
+
+	const int height = static_cast<int>(grid.size());
+	int width = 0;
+	for (const std::string& row : grid)
+		width = std::max(width, static_cast<int>(row.size()));
+
+	auto At = [&](int row, int col) { return col < static_cast<int>(grid[row].size()) ? grid[row][col] : '\0'; };
+
+	ForEachGridLine(height, width, [&](GridLineFamily, int row, int col, int dRow, int dCol)
+		{
+			int node = automaton.Start();
+			for (; 0 <= row && row < height && 0 <= col && col < width; row += dRow, col += dCol)
+				node = automaton.Step(node, At(row, col));
+		});
+
+	std::vector<long long> counts(words.size(), 0);
+
+	std::vector<long long> longCounts = automaton.CountWords();
+	for (size_t i = 0; i < longCounts.size(); ++i)
+		counts[longWordIndices[i]] = longCounts[i];
+
+	// A single letter reads the same in every direction, so it's just a letter count.
+	for (size_t i = 0; i < words.size(); ++i)
+		if (words[i].size() == 1)
+			for (int row = 0; row < height; ++row)
+				counts[i] += std::count(grid[row].begin(), grid[row].end(), words[i][0]);
+
+	return counts;
+}
+
+// Usage: ./this_program_name grid.txt words.txt (one word per line)
+int main_dictionary(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		printf("Usage: ./this_program_name grid.txt words.txt\n");
+		return -1;
+	}
+
+	Grid grid;
+	if (!ReadDataFromFile(argv[1], grid))
+		return -1;
+
+	Grid words;
+	if (!ReadDataFromFile(argv[2], words))
+		return -1;
+
+	std::vector<long long> counts = CountWordsDictionary(grid, words);
+	for (size_t i = 0; i < words.size(); ++i)
+		printf("%s: %lld\n", words[i].c_str(), counts[i]);
+
+	return 0;
+}
+
+int main_bitboard(int argc, char* argv[], bool isPart2)
+{
+	constexpr const char* defaultFilename = "small.txt";
+	const char* filename = argc == 2 ? argv[1] : defaultFilename;
+
+	if (argc != 2)
+	{
+		printf("Usage: ./this_program_name some_input_file.txt\n");
+		// return -1;
+		printf("Using default filename %s...\n", defaultFilename);
+	}
+
+	Grid grid;
+	if (!ReadDataFromFile(filename, grid))
+		return -1;
+
+	int total = isPart2 ? CountCrossBitboard(grid) : CountWordBitboard(grid, "XMAS");
+	PRINT(total);
+	return 0;
+}
+
+// The grid copied out once per line family, so that every direction is a plain left-to-right scan.
+// Each line ends with a '\n', so a word can never run from one line into the next.
+struct DirectionalLayouts
+{
+	std::string lines[4]; // indexed by `GridLineFamily`
+
+	DirectionalLayouts(const Grid& grid)
+	{
+		const int height = static_cast<int>(grid.size());
+		int width = 0;
+		for (const std::string& row : grid)
+			width = std::max(width, static_cast<int>(row.size()));
+
+		// every cell, plus one '\n' per line (there are never more than height + width lines)
+		for (std::string& layout : lines)
+			layout.reserve(static_cast<size_t>(height) * width + height + width);
+
+		ForEachGridLine(height, width, [&](GridLineFamily family, int row, int col, int dRow, int dCol)
+			{
+				std::string& layout = lines[static_cast<int>(family)];
+				for (; 0 <= row && row < height && 0 <= col && col < width; row += dRow, col += dCol)
+					layout += col < static_cast<int>(grid[row].size()) ? grid[row][col] : ' ';
+				layout += '\n';
+			});
+	}
+};
+
+// Counts (possibly overlapping) occurrences of `word` in `text`.
+// Only positions where both the first and last letters match get compared in full,
+// and those are found 32 (or 16) positions at a time.
+long long CountOccurrences(const std::string& text, const std::string& word)
+{
+	const size_t size = text.size();
+	const size_t length = word.size();
+	if (length == 0 || length > size)
+		return 0;
+
+	const char* data = text.data();
+	long long count = 0;
+	size_t pos = 0;
+
+	auto MatchesAt = [&](size_t at) { return std::equal(word.begin() + 1, word.end(), data + at + 1); };
+
+#if defined(__AVX2__)
+	const __m256i first = _mm256_set1_epi8(word.front());
+	const __m256i last = _mm256_set1_epi8(word.back());
+	for (; pos + length - 1 + 32 <= size; pos += 32)
+	{
+		__m256i atFirst = _mm256_cmpeq_epi8(first, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos)));
+		__m256i atLast = _mm256_cmpeq_epi8(last, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + length - 1)));
+		for (unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(atFirst, atLast))); mask; mask &= mask - 1)
+			count += MatchesAt(pos + std::countr_zero(mask));
+	}
+#elif defined(__SSE2__)
+	const __m128i first = _mm_set1_epi8(word.front());
+	const __m128i last = _mm_set1_epi8(word.back());
+	for (; pos + length - 1 + 16 <= size; pos += 16)
+	{
+		__m128i atFirst = _mm_cmpeq_epi8(first, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos)));
+		__m128i atLast = _mm_cmpeq_epi8(last, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + length - 1)));
+		for (unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(atFirst, atLast))); mask; mask &= mask - 1)
+			count += MatchesAt(pos + std::countr_zero(mask));
+	}
+#endif
+
+	for (; pos + length <= size; ++pos)
+		if (data[pos] == word.front())
+			count += MatchesAt(pos);
+
+	return count;
+}
+
+// Counts `word` in all eight directions: forwards and backwards along each of the four layouts.
+long long CountWordLayouts(const DirectionalLayouts& layouts, const std::string& word)
+{
+	// A single letter reads the same in every direction, so only count it once.
+	if (word.size() == 1)
+		return CountOccurrences(layouts.lines[static_cast<int>(GridLineFamily::ROWS)], word);
+
+	const std::string reversed(word.rbegin(), word.rend());
+
+	long long total = 0;
+	for (const std::string& layout : layouts.lines)
+		total += CountOccurrences(layout, word) + CountOccurrences(layout, reversed);
+	return total;
+}
+
+int main_01_layouts(int argc, char* argv[])
+{
+	constexpr const char* defaultFilename = "small.txt";
+	const char* filename = argc == 2 ? argv[1] : defaultFilename;
+
+	if (argc != 2)
+	{
+		printf("Usage: ./this_program_name some_input_file.txt\n");
+		// return -1;
+		printf("Using default filename %s...\n", defaultFilename);
+	}
+
+	Grid grid;
+	if (!ReadDataFromFile(filename, grid))
+		return -1;
+
+	const DirectionalLayouts layouts(grid);
+	long long total = CountWordLayouts(layouts, "XMAS");
+	PRINT(total);
+	return 0;
+}
+
+// Counts matches while the grid is read in one row at a time, keeping only the last few rows.
+// Works for any number of rows and columns (rows can even have different lengths).
+// Every match is counted exactly once, when the lowest row it touches arrives.
+struct StreamingWordCounter
+{
+	std::string word;
+	std::string reversed;
+	int length = 0;
+
+	// Ring buffer of the newest `window.size()` rows.
+	std::vector<std::string> window;
+	long long rowCount = 0;
+
+	long long wordTotal = 0;  // part 1
+	long long crossTotal = 0; // part 2
+
+	StreamingWordCounter(const std::string& word_) : word{ word_ }, reversed(word_.rbegin(), word_.rend())
+	{
+		length = static_cast<int>(word.size());
+		window.resize(std::max(length, 3)); // the X-MAS check needs 3 rows
+	}
+
+	// 0 is the newest row.
+	const std::string& RowsAgo(int rowsAgo) const
+	{
+		return window[(rowCount - 1 - rowsAgo) % static_cast<long long>(window.size())];
+	}
+
+	static char At(const std::string& row, int col)
+	{
+		return 0 <= col && col < static_cast<int>(row.size()) ? row[col] : '\0';
+	}
+
+	void AddRow(const std::string& row)
+	{
+		window[rowCount % static_cast<long long>(window.size())] = row; // reuses the old row's memory
+		++rowCount;
+
+		if (length > 0)
+			CountWords();
+		CountCrosses();
+	}
+
+	void CountWords()
+	{
+		const std::string& newest = RowsAgo(0);
+		wordTotal += CountOccurrences(newest, word);
+
+		// A single letter reads the same in every direction, so only count it once.
+		if (length == 1)
+			return;
+
+		wordTotal += CountOccurrences(newest, reversed);
+
+		if (rowCount < length)
+			return;
+
+		// Down, down-left and down-right from the top row of the window, and the same going up.
+		const std::string& top = RowsAgo(length - 1);
+		const int width = static_cast<int>(top.size());
+		for (int col = 0; col < width; ++col)
+		{
+			for (int dCol = -1; dCol <= 1; ++dCol)
+			{
+				bool isWord = true;
+				bool isReversed = true;
+				for (int k = 0; k < length && (isWord || isReversed); ++k)
+				{
+					char ch = At(RowsAgo(length - 1 - k), col + k * dCol);
+					isWord &= ch == word[k];
+					isReversed &= ch == reversed[k];
+				}
+				wordTotal += isWord + isReversed;
+			}
+		}
+	}
+
+	void CountCrosses()
+	{
+		if (rowCount < 3)
+			return;
+
+		const std::string& above = RowsAgo(2);
+		const std::string& middle = RowsAgo(1);
+		const std::string& below = RowsAgo(0);
+
+		auto IsMS = [](char a, char b) { return (a == 'M' && b == 'S') || (a == 'S' && b == 'M'); };
+
+		// The rows can be different lengths, so the diagonals go through `At()` rather than stopping a column early.
+		for (int col = 1; col < static_cast<int>(middle.size()); ++col)
+		{
+			if (middle[col] != 'A')
+				continue;
+
+			bool backslash = IsMS(At(above, col - 1), At(below, col + 1));
+			bool slash = IsMS(At(above, col + 1), At(below, col - 1));
+			crossTotal += backslash && slash;
+		}
+	}
+};
+
+int main_streaming(int argc, char* argv[], bool isPart2)
+{
+	constexpr const char* defaultFilename = "small.txt";
+	const char* filename = argc == 2 ? argv[1] : defaultFilename;
+
+	if (argc != 2)
+	{
+		printf("Usage: ./this_program_name some_input_file.txt\n");
+		// return -1;
+		printf("Using default filename %s...\n", defaultFilename);
+	}
+
+	std::fstream file(filename);
+	if (!file)
+	{
+		printf("sorry %s isn't a file\n", filename);
+		return -1;
+	}
+
+	StreamingWordCounter counter("XMAS");
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		while (!line.empty() && !isalpha(line.back()))
+			line.pop_back();
+
+		if (!line.empty())
+			counter.AddRow(line);
+	}
+
+	long long total = isPart2 ? counter.crossTotal : counter.wordTotal;
+	PRINT(total);
+	return 0;
+}
+
 int main(int argc, char* argv[])
 {
 	// return main_01(argc, argv);
+	// return main_bitboard(argc, argv, false);
+	// return main_bitboard(argc, argv, true);
+	// return main_dictionary(argc, argv);
+	// return main_01_layouts(argc, argv);
+	// return main_streaming(argc, argv, false);
+	// return main_streaming(argc, argv, true);
 	return main_02(argc, argv);
 }
@@ -1,8 +1,11 @@
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #define PRINT(x) std::cout << #x << ": " << (x) << "\n"
@@ -54,6 +57,127 @@ inline std::ostream& operator<<(std::ostream& stream, const Rule& rule)
 	return stream << '(' << rule.before << '|' << rule.after << ')';
 }
 
+// Answers "must `before` come before `after`?" in O(1).
+// Pages below `DENSE_PAGE_LIMIT` go in a bit matrix (row = before, column = after),
+// anything bigger falls back to a hash set of (before, after) pairs.
+struct PrecedenceIndex
+{
+	static constexpr int DENSE_PAGE_LIMIT = 4096;
+
+	int densePageCount = 0; // side length of the bit matrix
+	int wordsPerRow = 0;
+	std::vector<std::uint64_t> matrix;
+	std::unordered_set<std::uint64_t> sparseRules;
+
+	PrecedenceIndex() = default;
+
+	PrecedenceIndex(const std::vector<Rule>& rules)
+	{
+		for (const Rule& rule : rules)
+		{
+			if (IsDense(rule.before) && IsDense(rule.after))
+				densePageCount = std::max(densePageCount, std::max(rule.before, rule.after) + 1);
+		}
+
+		wordsPerRow = (densePageCount + 63) / 64;
+		matrix.assign(static_cast<size_t>(densePageCount) * wordsPerRow, 0);
+
+		for (const Rule& rule : rules)
+			Add(rule);
+	}
+
+	static bool IsDense(int page) { return 0 <= page && page < DENSE_PAGE_LIMIT; }
+
+	static std::uint64_t Key(int before, int after)
+	{
+		return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(before)) << 32) | static_cast<std::uint32_t>(after);
+	}
+
+	bool IsInMatrix(int before, int after) const
+	{
+		return 0 <= before && before < densePageCount && 0 <= after && after < densePageCount;
+	}
+
+	void Add(const Rule& rule)
+	{
+		if (IsInMatrix(rule.before, rule.after))
+			matrix[static_cast<size_t>(rule.before) * wordsPerRow + rule.after / 64] |= std::uint64_t{ 1 } << (rule.after % 64);
+		else
+			sparseRules.insert(Key(rule.before, rule.after));
+	}
+
+	void Remove(const Rule& rule)
+	{
+		if (IsInMatrix(rule.before, rule.after))
+			matrix[static_cast<size_t>(rule.before) * wordsPerRow + rule.after / 64] &= ~(std::uint64_t{ 1 } << (rule.after % 64));
+		else
+			sparseRules.erase(Key(rule.before, rule.after));
+	}
+
+	bool MustComeBefore(int before, int after) const
+	{
+		if (IsInMatrix(before, after))
+			return (matrix[static_cast<size_t>(before) * wordsPerRow + after / 64] >> (after % 64)) & 1;
+
+		return !sparseRules.empty() && sparseRules.count(Key(before, after)) != 0;
+	}
+
+	bool Contains(const Rule& rule) const { return MustComeBefore(rule.before, rule.after); }
+
+	bool HasRow(int before) const { return 0 <= before && before < densePageCount; }
+
+	// Bits of every page that `before` must come before (only the ones in the matrix).
+	const std::uint64_t* Row(int before) const { return &matrix[static_cast<size_t>(before) * wordsPerRow]; }
+};
+
+// Checks an update in one pass: every page's row of the matrix is ANDed with the pages seen so far.
+// Any overlap is a page that showed up earlier but had to come after this one.
+// The seen-pages mask is allocated once and cleared page by page, so checking an update doesn't allocate.
+struct UpdateValidator
+{
+	const PrecedenceIndex& rules;
+	std::vector<std::uint64_t> seen;
+
+	UpdateValidator(const PrecedenceIndex& rules_) : rules{ rules_ }, seen(rules_.wordsPerRow, 0) {}
+
+	bool IsCorrectlyOrdered(const std::vector<int>& pages)
+	{
+		bool isCorrect = true;
+		size_t checked = 0;
+
+		for (; checked < pages.size() && isCorrect; ++checked)
+		{
+			const int page = pages[checked];
+
+			if (rules.HasRow(page))
+			{
+				const std::uint64_t* mustComeBefore = rules.Row(page);
+				for (int w = 0; w < rules.wordsPerRow; ++w)
+					if (mustComeBefore[w] & seen[w])
+						isCorrect = false;
+			}
+
+			// Pairs that didn't fit in the matrix are only in the hash set.
+			if (!rules.sparseRules.empty())
+			{
+				for (size_t i = 0; i < checked && isCorrect; ++i)
+					if (!rules.IsInMatrix(page, pages[i]) && rules.MustComeBefore(page, pages[i]))
+						isCorrect = false;
+			}
+
+			if (rules.HasRow(page))
+				seen[page / 64] |= std::uint64_t{ 1 } << (page % 64);
+		}
+
+		// Only clear what was set, instead of the whole mask.
+		for (size_t i = 0; i < checked; ++i)
+			if (rules.HasRow(pages[i]))
+				seen[pages[i] / 64] &= ~(std::uint64_t{ 1 } << (pages[i] % 64));
+
+		return isCorrect;
+	}
+};
+
 struct Update
 {
 	using Page = int;
@@ -82,6 +206,15 @@ struct Update
 	};
 
 	void FixIncorrectOrder();
+
+	// Finds the page that ends up in the middle once the update is correctly ordered, without ordering the rest.
+	// Returns false if the rules can't place the middle page because of a cycle. Cycles that don't
+	// get in the way of the middle page aren't looked for, `ReorderByRules` checks every page.
+	bool FindMiddlePage(const PrecedenceIndex& rules, Page& middle) const;
+
+	// Puts the pages in an order that follows every rule (a topological sort over the rules between them).
+	// Returns false, and leaves the pages alone, if the rules for these pages contain a cycle.
+	bool ReorderByRules(const PrecedenceIndex& rules);
 };
 
 inline std::ostream& operator<<(std::ostream& stream, const Update& update)
@@ -136,6 +269,88 @@ void Update::FixIncorrectOrder()
 	isCorrectlyOrdered = true;
 }
 
+bool Update::FindMiddlePage(const PrecedenceIndex& rules, Page& middle) const
+{
+	const size_t count = pages.size();
+	const size_t middleIndex = (count - 1) / 2;
+
+	// The rules might have a cycle, or not order every pair, so they can't be handed to `nth_element` as a
+	// comparator. Instead look for the page that every other page is strictly before or after, with
+	// exactly `middleIndex` of them before it. That page is in the middle of any order that follows the rules.
+	for (size_t i = 0; i < count; ++i)
+	{
+		size_t pagesBefore = 0;
+		bool isPlaced = true;
+		for (size_t j = 0; j < count && isPlaced; ++j)
+		{
+			if (i == j)
+				continue;
+
+			const bool isBefore = rules.MustComeBefore(pages[j], pages[i]);
+			const bool isAfter = rules.MustComeBefore(pages[i], pages[j]);
+			isPlaced = isBefore != isAfter;
+			pagesBefore += isBefore;
+		}
+
+		if (isPlaced && pagesBefore == middleIndex)
+		{
+			middle = pages[i];
+			return true;
+		}
+	}
+
+	// The rules don't order these pages completely. Fall back to a full reorder,
+	// which either finds an order that works or finds the cycle.
+	Update ordered(*this);
+	if (!ordered.ReorderByRules(rules))
+		return false;
+
+	middle = ordered.pages[middleIndex];
+	return true;
+}
+
+bool Update::ReorderByRules(const PrecedenceIndex& rules)
+{
+	const size_t count = pages.size();
+
+	// how many of the other pages have to come before each page
+	std::vector<int> pagesBefore(count, 0);
+	for (size_t i = 0; i < count; ++i)
+		for (size_t j = 0; j < count; ++j)
+			if (i != j && rules.MustComeBefore(pages[j], pages[i]))
+				++pagesBefore[i];
+
+	std::vector<Page> ordered;
+	ordered.reserve(count);
+	std::vector<bool> isPlaced(count, false);
+
+	while (ordered.size() < count)
+	{
+		// take the first page that nothing left has to come before
+		size_t next = count;
+		for (size_t i = 0; i < count && next == count; ++i)
+			if (!isPlaced[i] && pagesBefore[i] == 0)
+				next = i;
+
+		if (next == count)
+		{
+			std::cout << "WARNING: THE RULES FOR " << pages << " CONTAIN A CYCLE\n";
+			return false;
+		}
+
+		isPlaced[next] = true;
+		ordered.emplace_back(pages[next]);
+
+		for (size_t i = 0; i < count; ++i)
+			if (!isPlaced[i] && rules.MustComeBefore(pages[next], pages[i]))
+				--pagesBefore[i];
+	}
+
+	pages = ordered;
+	isCorrectlyOrdered = true;
+	return true;
+}
+
 bool ReadDataFromFile(const std::string& filename, std::vector<Rule>& rules, std::vector<Update>& updates)
 {
 	std::fstream file(filename);
@@ -173,7 +388,7 @@ bool ReadDataFromFile(const std::string& filename, std::vector<Rule>& rules, std
 	return true;
 }
 
-void IdentifyIncorrectUpdates(std::vector<Update>& updates, const std::vector<Rule>& rules)
+void IdentifyIncorrectUpdates(std::vector<Update>& updates, const PrecedenceIndex& rules)
 {
 	for (Update& update : updates)
 	{
@@ -187,7 +402,7 @@ void IdentifyIncorrectUpdates(std::vector<Update>& updates, const std::vector<Ru
 			{
 				Rule generatedRule(update.pages[i], update.pages[j]);
 				generatedRules.emplace_back(generatedRule);
-				if (std::find(rules.begin(), rules.end(), generatedRule) != rules.end())
+				if (rules.Contains(generatedRule))
 					update.followedRules.emplace_back(generatedRule);
 			}
 		}
@@ -197,7 +412,7 @@ void IdentifyIncorrectUpdates(std::vector<Update>& updates, const std::vector<Ru
 
 		for (const Rule& flippedRule : generatedRules)
 		{
-			if (std::find(rules.begin(), rules.end(), flippedRule) != rules.end())
+			if (rules.Contains(flippedRule))
 			{
 				update.isCorrectlyOrdered = false;
 				update.violatedRules.emplace_back(flippedRule);
@@ -206,6 +421,14 @@ void IdentifyIncorrectUpdates(std::vector<Update>& updates, const std::vector<Ru
 	}
 }
 
+// Same result as `IdentifyIncorrectUpdates` for `isCorrectlyOrdered`, without building any rules.
+void FlagCorrectlyOrderedUpdates(std::vector<Update>& updates, const PrecedenceIndex& rules)
+{
+	UpdateValidator validator(rules);
+	for (Update& update : updates)
+		update.isCorrectlyOrdered = validator.IsCorrectlyOrdered(update.pages);
+}
+
 int main_01(int argc, char* argv[])
 {
 	constexpr const char* defaultFilename = "small.txt";
@@ -224,7 +447,9 @@ int main_01(int argc, char* argv[])
 	if (!ReadDataFromFile(filename, rules, updates))
 		return -1;
 
-	IdentifyIncorrectUpdates(updates, rules);
+	const PrecedenceIndex index(rules);
+	// IdentifyIncorrectUpdates(updates, index);
+	FlagCorrectlyOrderedUpdates(updates, index);
 
 	std::erase_if(updates, [](const Update& update) { return !update.isCorrectlyOrdered; });
 
@@ -257,18 +482,23 @@ int main_02(int argc, char* argv[])
 	if (!ReadDataFromFile(filename, rules, updates))
 		return -1;
 
-	IdentifyIncorrectUpdates(updates, rules);
+	const PrecedenceIndex index(rules);
+	// IdentifyIncorrectUpdates(updates, index);
+	FlagCorrectlyOrderedUpdates(updates, index);
 
 	std::erase_if(updates, [](const Update& update) { return update.isCorrectlyOrdered; });
 
 	// fix 'em here
-	for (Update& update : updates)
-		update.FixIncorrectOrder();
+	// for (Update& update : updates)
+	// 	update.FixIncorrectOrder();
 
+	// only the middle page is needed, so don't bother ordering the rest
 	int total = 0;
 	for (const Update& update : updates)
 	{
-		total += update.pages[(update.pages.size() - 1) / 2];
+		Update::Page middle;
+		if (update.FindMiddlePage(index, middle))
+			total += middle;
 	}
 
 	PRINT(total);
@@ -276,8 +506,143 @@ int main_02(int argc, char* argv[])
 	return 0;
 }
 
+// Keeps the totals for both parts up to date while rules get added and removed.
+// A rule can only change the outcome of updates that contain both of its pages, so every
+// pair of pages points at the updates it appears in, and only those get checked again.
+struct IncrementalChecker
+{
+	PrecedenceIndex index;
+	UpdateValidator validator;
+	std::vector<Update> updates;
+
+	// key = `PrecedenceIndex::Key(smaller page, bigger page)`
+	std::unordered_map<std::uint64_t, std::vector<int>> updatesWithPair;
+
+	// what each update currently adds to each part's total
+	std::vector<int> correctMiddles;
+	std::vector<int> incorrectMiddles;
+
+	long long correctTotal = 0;   // part 1
+	long long incorrectTotal = 0; // part 2
+
+	IncrementalChecker(const std::vector<Rule>& rules, const std::vector<Update>& updates_) :
+		index(rules), validator(index), updates{ updates_ },
+		correctMiddles(updates_.size(), 0), incorrectMiddles(updates_.size(), 0)
+	{
+		for (int u = 0; u < static_cast<int>(updates.size()); ++u)
+		{
+			const std::vector<Update::Page>& pages = updates[u].pages;
+			for (size_t i = 0; i < pages.size(); ++i)
+				for (size_t j = i + 1; j < pages.size(); ++j)
+					if (pages[i] != pages[j])
+						updatesWithPair[PairKey(pages[i], pages[j])].emplace_back(u);
+
+			Evaluate(u);
+		}
+	}
+
+	static std::uint64_t PairKey(int a, int b) { return PrecedenceIndex::Key(std::min(a, b), std::max(a, b)); }
+
+	void Evaluate(int u)
+	{
+		Update& update = updates[u];
+		correctTotal -= correctMiddles[u];
+		incorrectTotal -= incorrectMiddles[u];
+		correctMiddles[u] = 0;
+		incorrectMiddles[u] = 0;
+
+		update.isCorrectlyOrdered = validator.IsCorrectlyOrdered(update.pages);
+		if (update.isCorrectlyOrdered)
+		{
+			correctMiddles[u] = update.pages[(update.pages.size() - 1) / 2];
+		}
+		else
+		{
+			Update::Page middle;
+			if (update.FindMiddlePage(index, middle))
+				incorrectMiddles[u] = middle;
+		}
+
+		correctTotal += correctMiddles[u];
+		incorrectTotal += incorrectMiddles[u];
+	}
+
+	// Returns how many updates had to be checked again.
+	int AddRule(const Rule& rule)
+	{
+		if (index.Contains(rule))
+			return 0;
+		index.Add(rule);
+		return Recheck(rule);
+	}
+
+	int RemoveRule(const Rule& rule)
+	{
+		if (!index.Contains(rule))
+			return 0;
+		index.Remove(rule);
+		return Recheck(rule);
+	}
+
+	int Recheck(const Rule& rule)
+	{
+		auto it = updatesWithPair.find(PairKey(rule.before, rule.after));
+		if (it == updatesWithPair.end())
+			return 0;
+
+		for (int u : it->second)
+			Evaluate(u);
+		return static_cast<int>(it->second.size());
+	}
+};
+
+// Usage: ./this_program_name some_input_file.txt rule_changes.txt
+// Each line of the changes file is `+before|after` to add a rule or `-before|after` to remove one.
+int main_incremental(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		printf("Usage: ./this_program_name some_input_file.txt rule_changes.txt\n");
+		return -1;
+	}
+
+	std::vector<Rule> rules;
+	std::vector<Update> updates;
+
+	if (!ReadDataFromFile(argv[1], rules, updates))
+		return -1;
+
+	IncrementalChecker checker(rules, updates);
+	PRINT(checker.correctTotal);
+	PRINT(checker.incorrectTotal);
+
+	std::fstream changes(argv[2]);
+	if (!changes)
+	{
+		printf("sorry %s isn't a file\n", argv[2]);
+		return -1;
+	}
+
+	std::string line;
+	while (std::getline(changes, line))
+	{
+		if (line.length() < 2 || (line[0] != '+' && line[0] != '-'))
+			continue;
+
+		Rule rule(line.substr(1));
+		int recheckedCount = line[0] == '+' ? checker.AddRule(rule) : checker.RemoveRule(rule);
+
+		std::cout << line[0] << rule << " rechecked " << recheckedCount << " updates\n";
+		PRINT(checker.correctTotal);
+		PRINT(checker.incorrectTotal);
+	}
+
+	return 0;
+}
+
 int main(int argc, char* argv[])
 {
 	// return main_01(argc, argv);
+	// return main_incremental(argc, argv);
 	return main_02(argc, argv);
 }
@@ -1,6 +1,12 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #define PRINT(x) std::cout << #x << ": " << (x) << "\n"
@@ -247,6 +253,712 @@ int CountPossibleObstacles(const Grid& grid)
 	return total;
 }
 
+// For every cell and direction, the cell the guard stops at when walking that way:
+// right in front of the next obstacle, or `LEAVES_GRID` if there's nothing in the way.
+// With this the guard can go straight from one turn to the next instead of one cell at a time.
+struct JumpTable
+{
+	static constexpr int LEAVES_GRID = -1;
+
+	int height = 0;
+	int width = 0;
+	std::vector<int> stops[4]; // indexed by `Direction`, cells are `row * width + col`
+
+	JumpTable(const Grid& grid)
+	{
+		height = static_cast<int>(grid.size());
+		width = height > 0 ? static_cast<int>(grid[0].size()) : 0;
+		for (std::vector<int>& table : stops)
+			table.assign(static_cast<size_t>(height) * width, LEAVES_GRID);
+
+		auto IsObstruction = [&](int row, int col) { return grid[row][col] == Symbols::OBSTRUCTION; };
+
+		for (int col = 0; col < width; ++col)
+		{
+			// going north: sweep downwards, remembering the closest obstacle above
+			for (int row = 0, obstacle = -1; row < height; ++row)
+			{
+				if (IsObstruction(row, col))
+					obstacle = row;
+				else if (obstacle >= 0)
+					Stops(Direction::N)[Cell(row, col)] = Cell(obstacle + 1, col);
+			}
+
+			// going south: the same, sweeping upwards
+			for (int row = height - 1, obstacle = -1; row >= 0; --row)
+			{
+				if (IsObstruction(row, col))
+					obstacle = row;
+				else if (obstacle >= 0)
+					Stops(Direction::S)[Cell(row, col)] = Cell(obstacle - 1, col);
+			}
+		}
+
+		for (int row = 0; row < height; ++row)
+		{
+			for (int col = width - 1, obstacle = -1; col >= 0; --col)
+			{
+				if (IsObstruction(row, col))
+					obstacle = col;
+				else if (obstacle >= 0)
+					Stops(Direction::E)[Cell(row, col)] = Cell(row, obstacle - 1);
+			}
+
+			for (int col = 0, obstacle = -1; col < width; ++col)
+			{
+				if (IsObstruction(row, col))
+					obstacle = col;
+				else if (obstacle >= 0)
+					Stops(Direction::W)[Cell(row, col)] = Cell(row, obstacle + 1);
+			}
+		}
+	}
+
+	int Cell(int row, int col) const { return row * width + col; }
+
+	std::vector<int>& Stops(Direction dir) { return stops[static_cast<int>(dir)]; }
+	const std::vector<int>& Stops(Direction dir) const { return stops[static_cast<int>(dir)]; }
+
+	// Where the guard at `cell` stops when walking in `dir`, as if there was also an obstacle
+	// at `extraObstacle` (pass `LEAVES_GRID` for none). The table itself is never changed.
+	int Jump(int cell, Direction dir, int extraObstacle = LEAVES_GRID) const
+	{
+		int stop = Stops(dir)[cell];
+		if (extraObstacle == LEAVES_GRID)
+			return stop;
+
+		const int row = cell / width, col = cell % width;
+		const int extraRow = extraObstacle / width, extraCol = extraObstacle % width;
+
+		switch (dir)
+		{
+		case Direction::N:
+			if (extraCol == col && extraRow < row && (stop == LEAVES_GRID || extraRow >= stop / width))
+				stop = Cell(extraRow + 1, col);
+			break;
+		case Direction::S:
+			if (extraCol == col && extraRow > row && (stop == LEAVES_GRID || extraRow <= stop / width))
+				stop = Cell(extraRow - 1, col);
+			break;
+		case Direction::E:
+			if (extraRow == row && extraCol > col && (stop == LEAVES_GRID || extraCol <= stop % width))
+				stop = Cell(row, extraCol - 1);
+			break;
+		case Direction::W:
+			if (extraRow == row && extraCol < col && (stop == LEAVES_GRID || extraCol >= stop % width))
+				stop = Cell(row, extraCol + 1);
+			break;
+		default: break;
+		}
+		return stop;
+	}
+
+	// How much a cell index changes per step when walking in a straight line from `from` to `to`.
+	int StepTowards(int from, int to) const
+	{
+		if (to / width == from / width)
+			return to > from ? 1 : -1;
+		return to > from ? width : -width;
+	}
+
+	// Where the guard would leave the grid when walking from `cell` in `dir` with nothing in the way.
+	int LastCellBeforeEdge(int cell, Direction dir) const
+	{
+		const int row = cell / width, col = cell % width;
+		switch (dir)
+		{
+		case Direction::N: return Cell(0, col);
+		case Direction::S: return Cell(height - 1, col);
+		case Direction::E: return Cell(row, width - 1);
+		case Direction::W: return Cell(row, 0);
+		default: return cell;
+		}
+	}
+};
+
+// Same as `CountVisitedPositions`, but the guard jumps from turn to turn.
+// Every cell still has to be marked to count the distinct ones, but no more bounds or obstacle checks are needed.
+int CountVisitedPositionsJumping(Grid& grid)
+{
+	const Position startPos = FindAndClearStartPosition(grid);
+	const JumpTable jumps(grid);
+
+	std::vector<bool> visited(static_cast<size_t>(jumps.height) * jumps.width, false);
+	int total = 0;
+
+	auto MarkSegment = [&](int from, int to)
+		{
+			int step = jumps.StepTowards(from, to);
+			for (int cell = from;; cell += step)
+			{
+				if (!visited[cell])
+				{
+					visited[cell] = true;
+					++total;
+				}
+				if (cell == to)
+					break;
+			}
+		};
+
+	int cell = jumps.Cell(static_cast<int>(startPos.row), static_cast<int>(startPos.col));
+	Direction dir = Direction::N;
+
+	while (true)
+	{
+		int stop = jumps.Jump(cell, dir);
+		if (stop == JumpTable::LEAVES_GRID)
+		{
+			MarkSegment(cell, jumps.LastCellBeforeEdge(cell, dir));
+			break;
+		}
+
+		MarkSegment(cell, stop);
+		cell = stop;
+		dir = TurnRight(dir);
+	}
+
+	return total;
+}
+
+// Walks the guard with the jump table, pretending there's an obstacle at `extraObstacle`.
+// Only the cells where the guard turns are remembered (one bit per direction), and
+// running into the same obstacle in the same direction twice means it's stuck in a loop.
+// `turnStates` has to be all zeroes, and is left that way.
+bool IsGuardLooping(const JumpTable& jumps, int startCell, int extraObstacle,
+	std::vector<unsigned char>& turnStates, std::vector<int>& touchedCells, Direction startDir = Direction::N)
+{
+	bool isLooping = false;
+	int cell = startCell;
+	Direction dir = startDir;
+
+	while (true)
+	{
+		int stop = jumps.Jump(cell, dir, extraObstacle);
+		if (stop == JumpTable::LEAVES_GRID)
+			break;
+
+		unsigned char bit = static_cast<unsigned char>(VisitedDirection(dir));
+		if (turnStates[stop] & bit)
+		{
+			isLooping = true;
+			break;
+		}
+
+		if (turnStates[stop] == 0)
+			touchedCells.emplace_back(stop);
+		turnStates[stop] |= bit;
+
+		cell = stop;
+		dir = TurnRight(dir);
+	}
+
+	for (int touched : touchedCells)
+		turnStates[touched] = 0;
+	touchedCells.clear();
+
+	return isLooping;
+}
+
+// Same as `CountPossibleObstacles`, but every simulation jumps from turn to turn.
+int CountPossibleObstaclesJumping(const Grid& grid)
+{
+	Grid clearedGrid{ grid };
+	const Position startPos = FindAndClearStartPosition(clearedGrid);
+	const JumpTable jumps(clearedGrid);
+	const int startCell = jumps.Cell(static_cast<int>(startPos.row), static_cast<int>(startPos.col));
+
+	std::vector<unsigned char> turnStates(static_cast<size_t>(jumps.height) * jumps.width, 0);
+	std::vector<int> touchedCells;
+
+	int total = 0;
+	for (int row = 0; row < jumps.height; ++row)
+	{
+		for (int col = 0; col < jumps.width; ++col)
+		{
+			if (grid[row][col] == Symbols::OBSTRUCTION || grid[row][col] == Symbols::START)
+				continue;
+
+			if (IsGuardLooping(jumps, startCell, jumps.Cell(row, col), turnStates, touchedCells))
+				++total;
+		}
+	}
+	return total;
+}
+
+struct ObstacleCandidate
+{
+	int cell;         // where the obstacle goes
+	int previousCell; // where the guard was right before first stepping onto `cell`
+	Direction dir;    // the way the guard was walking
+};
+
+// An obstacle can only change anything if it's somewhere on the original patrol path.
+// And up until the guard first reaches that cell, the walk is the same as without it.
+// So this records every cell on the path once, with where the guard was just before first entering it.
+std::vector<ObstacleCandidate> FindObstacleCandidates(const JumpTable& jumps, int startCell)
+{
+	std::vector<ObstacleCandidate> candidates;
+	std::vector<bool> visited(static_cast<size_t>(jumps.height) * jumps.width, false);
+	visited[startCell] = true; // can't put an obstacle on the guard
+
+	int cell = startCell;
+	Direction dir = Direction::N;
+	while (true)
+	{
+		int stop = jumps.Jump(cell, dir);
+		int segmentEnd = stop == JumpTable::LEAVES_GRID ? jumps.LastCellBeforeEdge(cell, dir) : stop;
+		int step = jumps.StepTowards(cell, segmentEnd);
+
+		for (int previous = cell; previous != segmentEnd; previous += step)
+		{
+			int next = previous + step;
+			if (!visited[next])
+			{
+				visited[next] = true;
+				candidates.push_back({ next, previous, dir });
+			}
+		}
+
+		if (stop == JumpTable::LEAVES_GRID)
+			break;
+
+		cell = stop;
+		dir = TurnRight(dir);
+	}
+
+	return candidates;
+}
+
+// Tries only the cells on the patrol path, each one resuming from just before the guard first got there.
+int CountPossibleObstaclesPruned(const Grid& grid)
+{
+	Grid clearedGrid{ grid };
+	const Position startPos = FindAndClearStartPosition(clearedGrid);
+	const JumpTable jumps(clearedGrid);
+	const int startCell = jumps.Cell(static_cast<int>(startPos.row), static_cast<int>(startPos.col));
+
+	std::vector<unsigned char> turnStates(static_cast<size_t>(jumps.height) * jumps.width, 0);
+	std::vector<int> touchedCells;
+
+	int total = 0;
+	for (const ObstacleCandidate& candidate : FindObstacleCandidates(jumps, startCell))
+		if (IsGuardLooping(jumps, candidate.previousCell, candidate.cell, turnStates, touchedCells, candidate.dir))
+			++total;
+
+	return total;
+}
+
+// Loop detection that can be reused for candidate after candidate without clearing anything.
+// A turn state counts as visited only if its stamp matches the current generation,
+// so starting a new simulation is just bumping the generation.
+struct LoopDetector
+{
+	std::vector<unsigned> stamps; // [cell * 4 + direction]
+	unsigned generation = 0;
+
+	LoopDetector(const JumpTable& jumps) : stamps(static_cast<size_t>(jumps.height) * jumps.width * 4, 0) {}
+
+	bool IsLooping(const JumpTable& jumps, int startCell, int extraObstacle, Direction startDir)
+	{
+		if (++generation == 0)
+		{
+			// wrapped around, so old stamps could look current
+			std::fill(stamps.begin(), stamps.end(), 0);
+			generation = 1;
+		}
+
+		int cell = startCell;
+		Direction dir = startDir;
+		while (true)
+		{
+			int stop = jumps.Jump(cell, dir, extraObstacle);
+			if (stop == JumpTable::LEAVES_GRID)
+				return false;
+
+			unsigned& stamp = stamps[static_cast<size_t>(stop) * 4 + static_cast<int>(dir)];
+			if (stamp == generation)
+				return true;
+			stamp = generation;
+
+			cell = stop;
+			dir = TurnRight(dir);
+		}
+	}
+};
+
+// Shares the candidates out between threads and counts the ones that make the guard loop.
+// `makeCheck` is called once per thread, and returns what that thread uses to check a candidate.
+template <typename MakeCheck>
+int CountLoopingCandidatesInParallel(const std::vector<ObstacleCandidate>& candidates, MakeCheck makeCheck)
+{
+	unsigned threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 1;
+
+	// Small batches, so a thread that got a few long simulations doesn't hold everyone else up.
+	constexpr size_t batchSize = 64;
+	std::atomic<size_t> nextCandidate = 0;
+	std::atomic<int> total = 0;
+
+	auto Work = [&]
+		{
+			auto IsLooping = makeCheck();
+			int loopsFound = 0;
+
+			for (size_t first = nextCandidate.fetch_add(batchSize); first < candidates.size(); first = nextCandidate.fetch_add(batchSize))
+			{
+				size_t last = std::min(first + batchSize, candidates.size());
+				for (size_t i = first; i < last; ++i)
+					if (IsLooping(candidates[i]))
+						++loopsFound;
+			}
+
+			total += loopsFound;
+		};
+
+	std::vector<std::thread> workers;
+	for (unsigned i = 0; i < threadCount; ++i)
+		workers.emplace_back(Work);
+	for (std::thread& worker : workers)
+		worker.join();
+
+	return total;
+}
+
+// Same as `CountPossibleObstaclesPruned`, but the candidates are shared out between threads.
+// The grid and jump table are only ever read, and every thread has its own `LoopDetector`.
+int CountPossibleObstaclesParallel(const Grid& grid)
+{
+	Grid clearedGrid{ grid };
+	const Position startPos = FindAndClearStartPosition(clearedGrid);
+	const JumpTable jumps(clearedGrid);
+	const int startCell = jumps.Cell(static_cast<int>(startPos.row), static_cast<int>(startPos.col));
+
+	return CountLoopingCandidatesInParallel(FindObstacleCandidates(jumps, startCell), [&jumps]
+		{
+			return [&jumps, detector = LoopDetector(jumps)](const ObstacleCandidate& candidate) mutable
+				{
+					return detector.IsLooping(jumps, candidate.previousCell, candidate.cell, candidate.dir);
+				};
+		});
+}
+
+// Treats the guard as a function from one turn state (cell, direction it's about to walk) to the next,
+// and looks for a cycle with Brent's algorithm. Only two states are ever stored, so no visited array needed.
+bool IsGuardLoopingBrent(const JumpTable& jumps, int startCell, int extraObstacle, Direction startDir)
+{
+	constexpr long long LEFT_GRID = -1;
+
+	auto Next = [&](long long state)
+		{
+			int cell = static_cast<int>(state / 4);
+			Direction dir = static_cast<Direction>(state % 4);
+
+			int stop = jumps.Jump(cell, dir, extraObstacle);
+			if (stop == JumpTable::LEAVES_GRID)
+				return LEFT_GRID;
+			return static_cast<long long>(stop) * 4 + static_cast<int>(TurnRight(dir));
+		};
+
+	long long power = 1;
+	long long cycleLength = 1;
+	long long tortoise = static_cast<long long>(startCell) * 4 + static_cast<int>(startDir);
+	long long hare = Next(tortoise);
+
+	while (hare != tortoise)
+	{
+		if (hare == LEFT_GRID)
+			return false;
+
+		// the tortoise teleports to the hare every power of two steps
+		if (power == cycleLength)
+		{
+			tortoise = hare;
+			power *= 2;
+			cycleLength = 0;
+		}
+
+		hare = Next(hare);
+		++cycleLength;
+	}
+
+	return true;
+}
+
+// Same as `CountPossibleObstaclesParallel`, but with Brent's algorithm, so the threads don't need any state at all.
+int CountPossibleObstaclesBrent(const Grid& grid)
+{
+	Grid clearedGrid{ grid };
+	const Position startPos = FindAndClearStartPosition(clearedGrid);
+	const JumpTable jumps(clearedGrid);
+	const int startCell = jumps.Cell(static_cast<int>(startPos.row), static_cast<int>(startPos.col));
+
+	return CountLoopingCandidatesInParallel(FindObstacleCandidates(jumps, startCell), [&jumps]
+		{
+			return [&jumps](const ObstacleCandidate& candidate)
+				{
+					return IsGuardLoopingBrent(jumps, candidate.previousCell, candidate.cell, candidate.dir);
+				};
+		});
+}
+
+// The map as just a list of obstacles, for huge maps that are mostly empty.
+// Each row and column keeps the sorted positions of its obstacles, so finding the next one
+// in some direction is a binary search, and nothing else about the map is stored.
+struct SparseMap
+{
+	int height = 0;
+	int width = 0;
+	int startRow = -1;
+	int startCol = -1;
+	std::unordered_map<int, std::vector<int>> obstaclesInRow; // row -> sorted columns
+	std::unordered_map<int, std::vector<int>> obstaclesInCol; // column -> sorted rows
+
+	bool ReadFromFile(const char* filename)
+	{
+		std::fstream file(filename);
+		if (!file)
+		{
+			printf("sorry %s isn't a file\n", filename);
+			return false;
+		}
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+
+			for (int col = 0; col < static_cast<int>(line.size()); ++col)
+			{
+				if (line[col] == Symbols::OBSTRUCTION)
+				{
+					obstaclesInRow[height].emplace_back(col); // rows are read in order, so these stay sorted
+					obstaclesInCol[col].emplace_back(height);
+				}
+				else if (line[col] == Symbols::START)
+				{
+					startRow = height;
+					startCol = col;
+				}
+			}
+
+			width = std::max(width, static_cast<int>(line.size()));
+			++height;
+		}
+
+		return startRow >= 0;
+	}
+
+	// Moves (row, col) to where the guard stops in front of the next obstacle in `dir`, treating
+	// (extraRow, extraCol) as an obstacle too. Returns false if the guard walks off the map instead.
+	bool CastRay(int& row, int& col, Direction dir, int extraRow = -1, int extraCol = -1) const
+	{
+		auto FindIn = [](const std::unordered_map<int, std::vector<int>>& lines, int line) -> const std::vector<int>*
+			{
+				auto it = lines.find(line);
+				return it == lines.end() ? nullptr : &it->second;
+			};
+
+		switch (dir)
+		{
+		case Direction::N:
+		case Direction::S:
+		{
+			int obstacle = -1;
+			if (const std::vector<int>* rows = FindIn(obstaclesInCol, col))
+			{
+				if (dir == Direction::N)
+				{
+					auto it = std::lower_bound(rows->begin(), rows->end(), row);
+					if (it != rows->begin())
+						obstacle = *std::prev(it);
+				}
+				else
+				{
+					auto it = std::upper_bound(rows->begin(), rows->end(), row);
+					if (it != rows->end())
+						obstacle = *it;
+				}
+			}
+
+			if (extraCol == col)
+			{
+				if (dir == Direction::N && extraRow < row && extraRow > obstacle)
+					obstacle = extraRow;
+				if (dir == Direction::S && extraRow > row && (obstacle < 0 || extraRow < obstacle))
+					obstacle = extraRow;
+			}
+
+			if (obstacle < 0)
+				return false;
+			row = dir == Direction::N ? obstacle + 1 : obstacle - 1;
+			return true;
+		}
+		case Direction::E:
+		case Direction::W:
+		{
+			int obstacle = -1;
+			if (const std::vector<int>* cols = FindIn(obstaclesInRow, row))
+			{
+				if (dir == Direction::W)
+				{
+					auto it = std::lower_bound(cols->begin(), cols->end(), col);
+					if (it != cols->begin())
+						obstacle = *std::prev(it);
+				}
+				else
+				{
+					auto it = std::upper_bound(cols->begin(), cols->end(), col);
+					if (it != cols->end())
+						obstacle = *it;
+				}
+			}
+
+			if (extraRow == row)
+			{
+				if (dir == Direction::W && extraCol < col && extraCol > obstacle)
+					obstacle = extraCol;
+				if (dir == Direction::E && extraCol > col && (obstacle < 0 || extraCol < obstacle))
+					obstacle = extraCol;
+			}
+
+			if (obstacle < 0)
+				return false;
+			col = dir == Direction::W ? obstacle + 1 : obstacle - 1;
+			return true;
+		}
+		default:
+			return false;
+		}
+	}
+
+	// Where the guard ends up on the edge of the map when nothing is in the way.
+	void WalkToEdge(int& row, int& col, Direction dir) const
+	{
+		switch (dir)
+		{
+		case Direction::N: row = 0; break;
+		case Direction::S: row = height - 1; break;
+		case Direction::E: col = width - 1; break;
+		case Direction::W: col = 0; break;
+		default: break;
+		}
+	}
+
+	static std::uint64_t Key(int row, int col, int extra = 0)
+	{
+		return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(row)) << 34) |
+			(static_cast<std::uint64_t>(static_cast<std::uint32_t>(col)) << 2) | static_cast<std::uint64_t>(extra);
+	}
+};
+
+// Calls `onFirstVisit(row, col, previousRow, previousCol, dir)` for every cell on the patrol path
+// the first time the guard steps onto it (the start cell is left out).
+// Instead of a visited flag per cell, the straight segments walked so far are kept per row and
+// per column, so the memory used depends on the number of turns, not on the size of the map.
+template <typename Callback>
+void WalkPatrolPath(const SparseMap& map, Callback onFirstVisit)
+{
+	struct Segment { int from, to; }; // inclusive, from <= to
+	std::unordered_map<int, std::vector<Segment>> segmentsInRow;
+	std::unordered_map<int, std::vector<Segment>> segmentsInCol;
+
+	auto IsOn = [](const std::unordered_map<int, std::vector<Segment>>& segments, int line, int position)
+		{
+			auto it = segments.find(line);
+			if (it == segments.end())
+				return false;
+			for (const Segment& segment : it->second)
+				if (segment.from <= position && position <= segment.to)
+					return true;
+			return false;
+		};
+
+	int row = map.startRow;
+	int col = map.startCol;
+	Direction dir = Direction::N;
+
+	while (true)
+	{
+		int stopRow = row, stopCol = col;
+		bool isStopped = map.CastRay(stopRow, stopCol, dir);
+		if (!isStopped)
+			map.WalkToEdge(stopRow, stopCol, dir);
+
+		const int dRow = (stopRow > row) - (stopRow < row);
+		const int dCol = (stopCol > col) - (stopCol < col);
+		for (int r = row, c = col; r != stopRow || c != stopCol; r += dRow, c += dCol)
+		{
+			int nextRow = r + dRow, nextCol = c + dCol;
+			if (!IsOn(segmentsInRow, nextRow, nextCol) && !IsOn(segmentsInCol, nextCol, nextRow) &&
+				!(nextRow == map.startRow && nextCol == map.startCol))
+				onFirstVisit(nextRow, nextCol, r, c, dir);
+		}
+
+		if (dRow == 0)
+			segmentsInRow[row].push_back({ std::min(col, stopCol), std::max(col, stopCol) });
+		else
+			segmentsInCol[col].push_back({ std::min(row, stopRow), std::max(row, stopRow) });
+
+		if (!isStopped)
+			break;
+
+		row = stopRow;
+		col = stopCol;
+		dir = TurnRight(dir);
+	}
+}
+
+long long CountVisitedPositionsSparse(const SparseMap& map)
+{
+	long long total = 1; // the start
+	WalkPatrolPath(map, [&total](int, int, int, int, Direction) { ++total; });
+	return total;
+}
+
+// Part 2 on a sparse map: every cell on the path is tried, resuming from just before the guard
+// first reached it. The turn states of each simulation go in a hash set that gets reused.
+long long CountPossibleObstaclesSparse(const SparseMap& map)
+{
+	std::unordered_set<std::uint64_t> turnStates;
+	long long total = 0;
+
+	WalkPatrolPath(map, [&](int obstacleRow, int obstacleCol, int row, int col, Direction dir)
+		{
+			turnStates.clear();
+			while (true)
+			{
+				if (!map.CastRay(row, col, dir, obstacleRow, obstacleCol))
+					return;
+
+				if (!turnStates.insert(SparseMap::Key(row, col, static_cast<int>(dir))).second)
+				{
+					++total;
+					return;
+				}
+
+				dir = TurnRight(dir);
+			}
+		});
+
+	return total;
+}
+
+int main_sparse(const char* filename)
+{
+	SparseMap map;
+	if (!map.ReadFromFile(filename))
+		return -1;
+
+	// long long total = CountVisitedPositionsSparse(map); // part 1
+	long long total = CountPossibleObstaclesSparse(map); // part 2
+	PRINT(total);
+
+	return 0;
+}
+
 int main(int argc, char* argv[])
 {
 	constexpr const char* defaultFilename = "small.txt";
@@ -259,13 +971,20 @@ int main(int argc, char* argv[])
 		printf("Using default filename %s...\n", defaultFilename);
 	}
 
+	// return main_sparse(filename);
+
 	Grid grid;
 
 	if (!ReadDataFromFile(filename, grid))
 		return -1;
 
 	// int total = CountVisitedPositions(grid); // part 1
-	int total = CountPossibleObstacles(grid); // part 2
+	// int total = CountVisitedPositionsJumping(grid); // part 1
+	// int total = CountPossibleObstacles(grid); // part 2
+	// int total = CountPossibleObstaclesJumping(grid); // part 2
+	// int total = CountPossibleObstaclesPruned(grid); // part 2
+	// int total = CountPossibleObstaclesParallel(grid); // part 2
+	int total = CountPossibleObstaclesBrent(grid); // part 2
 	PRINT(total);
 
 	return 0;
@@ -1,7 +1,14 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <mutex>
 #include <string>
 #include <sstream>
+#include <thread>
 #include <vector>
 
 #define PRINT(x) std::cout << #x << ": " << (x) << "\n"
@@ -33,6 +40,52 @@ inline std::ostream& operator<<(std::ostream& stream, const Operator& op)
 
 using BigNumber = unsigned long long;
 
+// Powers of ten up to the biggest one that fits in a BigNumber (10^19).
+static constexpr auto powersOfTen = []
+	{
+		std::array<BigNumber, 20> table{};
+		table[0] = 1;
+		for (unsigned i = 1; i < table.size(); ++i)
+			table[i] = table[i - 1] * 10;
+		return table;
+	}();
+
+// The power of ten that shifts a number left by as many digits as `number` has (10 for 7, 1000 for 123).
+static constexpr BigNumber DigitShift(BigNumber number)
+{
+	unsigned digits = 1;
+	while (digits < powersOfTen.size() && number >= powersOfTen[digits])
+		++digits;
+	return digits < powersOfTen.size() ? powersOfTen[digits] : 0; // 0 = more digits than fit
+}
+
+static constexpr BigNumber OVERFLOWED = std::numeric_limits<BigNumber>::max();
+
+// `total || number` without going through strings: total * 10^(digits in number) + number.
+// If the result doesn't fit, returns `OVERFLOWED`, which is bigger than any test value.
+static constexpr BigNumber Concatenate(BigNumber total, BigNumber number)
+{
+	const BigNumber shift = DigitShift(number);
+	if (shift == 0 || total > (OVERFLOWED - number) / shift)
+		return OVERFLOWED;
+	return total * shift + number;
+}
+
+static_assert(Concatenate(12, 345) == 12345);
+static_assert(Concatenate(0, 7) == 7);
+static_assert(Concatenate(OVERFLOWED / 10, 99) == OVERFLOWED);
+
+// `total + number` and `total * number`, saturating to `OVERFLOWED` the same way as `Concatenate`.
+static constexpr BigNumber SaturatingAdd(BigNumber total, BigNumber number)
+{
+	return total > OVERFLOWED - number ? OVERFLOWED : total + number;
+}
+
+static constexpr BigNumber SaturatingMultiply(BigNumber total, BigNumber number)
+{
+	return number != 0 && total > OVERFLOWED / number ? OVERFLOWED : total * number;
+}
+
 struct Equation
 {
 	BigNumber testValue = 0;
@@ -64,9 +117,7 @@ struct Equation
 			{
 			case Operator::ADD:      total += number; break;
 			case Operator::MULTIPLY: total *= number; break;
-			case Operator::CONCAT:
-				total = std::stoull(std::to_string(total) + std::to_string(number));
-				break;
+			case Operator::CONCAT:   total = Concatenate(total, number); break;
 			default: break;
 			}
 		}
@@ -162,7 +213,7 @@ void FlagTrueEquations(std::vector<Equation>& equations)
 				{
 				case Operator::ADD:      total += number; break;
 				case Operator::MULTIPLY: total *= number; break;
-				case Operator::CONCAT:   total = std::stoull(std::to_string(total) + std::to_string(number)); break;
+				case Operator::CONCAT:   total = Concatenate(total, number); break;
 				default:                 break;
 				}
 
@@ -182,6 +233,207 @@ void FlagTrueEquations(std::vector<Equation>& equations)
 	}
 }
 
+// Works backward from the test value: undo the last number with every operator that could have
+// produced the current target, and only recurse when that undo is exact. Subtraction must not go
+// negative, division must leave no remainder and a concatenation must end in the number's digits,
+// so most branches die immediately instead of expanding into all 3^n combinations.
+static bool CanReachBackward(const std::vector<unsigned>& numbers, size_t count, BigNumber target, bool allowConcat)
+{
+	if (count == 1)
+		return target == numbers.front();
+
+	const BigNumber number = numbers[count - 1];
+
+	if (allowConcat)
+	{
+		const BigNumber shift = DigitShift(number);
+		if (shift != 0 && target % shift == number && CanReachBackward(numbers, count - 1, target / shift, allowConcat))
+			return true;
+	}
+
+	if (number == 0)
+	{
+		// anything times 0 is 0, so whatever came before works
+		if (target == 0)
+			return true;
+	}
+	else if (target % number == 0 && CanReachBackward(numbers, count - 1, target / number, allowConcat))
+		return true;
+
+	return target >= number && CanReachBackward(numbers, count - 1, target - number, allowConcat);
+}
+
+// Same result as `FlagTrueEquations` (or `OldFlagTrueEquations` when `allowConcat` is false), but pruned from the back.
+void FlagTrueEquationsBackward(std::vector<Equation>& equations, bool allowConcat = true)
+{
+	for (Equation& equation : equations)
+		equation.isTrueEquation = CanReachBackward(equation.numbers, equation.numbers.size(), equation.testValue, allowConcat);
+}
+
+// Depth-first version of the loop in `FlagTrueEquations`: tries every operator for `numbers[index]` onwards,
+// starting from `total`. Gives up early once `solved` is set, i.e. another thread found a match for this equation.
+// A total that's already too big is only given up on from `pruneFrom` onwards, once there are no zeros left,
+// since `* 0` can still bring it back down before that. Totals saturate rather than wrap, so an unpruned
+// total that has overflowed can't come back around to the test value.
+static bool SearchForward(const Equation& equation, size_t index, BigNumber total, size_t pruneFrom, const std::atomic<bool>& solved)
+{
+	if ((index >= pruneFrom && total > equation.testValue) || solved.load(std::memory_order_relaxed))
+		return false;
+	if (index == equation.numbers.size())
+		return total == equation.testValue;
+
+	const BigNumber number = equation.numbers[index];
+	return SearchForward(equation, index + 1, SaturatingAdd(total, number), pruneFrom, solved)
+		|| SearchForward(equation, index + 1, SaturatingMultiply(total, number), pruneFrom, solved)
+		|| SearchForward(equation, index + 1, Concatenate(total, number), pruneFrom, solved);
+}
+
+// The first index after the last 0 in `numbers`, i.e. where `SearchForward` can start pruning.
+static size_t FirstIndexAfterLastZero(const std::vector<unsigned>& numbers)
+{
+	for (size_t i = numbers.size(); i > 1; --i)
+		if (numbers[i - 1] == 0)
+			return i;
+	return 1;
+}
+
+// One piece of work: the part of an equation's operator tree whose first `prefixLength` operators
+// are given by `prefix` (in the same base 3 encoding as `GenerateOperatorsFromCombination`).
+struct EquationTask
+{
+	size_t equationIndex = 0;
+	unsigned prefixLength = 0;
+	BigNumber prefix = 0;
+	BigNumber cost = 0; // how many operator combinations this task has to try at most
+};
+
+// A task queue per thread. The owner takes from the front, other threads steal from the back.
+class WorkStealingQueues
+{
+public:
+	explicit WorkStealingQueues(unsigned count) : queues(count) {}
+
+	void Push(unsigned owner, const EquationTask& task)
+	{
+		std::lock_guard<std::mutex> lock(queues[owner].mutex);
+		queues[owner].tasks.push_back(task);
+	}
+
+	bool Pop(unsigned owner, EquationTask& task)
+	{
+		if (TakeFrom(owner, task, true))
+			return true;
+		for (unsigned i = 1; i < queues.size(); ++i)
+			if (TakeFrom((owner + i) % queues.size(), task, false))
+				return true;
+		return false;
+	}
+
+private:
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<EquationTask> tasks;
+	};
+
+	bool TakeFrom(unsigned index, EquationTask& task, bool fromFront)
+	{
+		Queue& queue = queues[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.tasks.empty())
+			return false;
+
+		task = fromFront ? queue.tasks.front() : queue.tasks.back();
+		if (fromFront)
+			queue.tasks.pop_front();
+		else
+			queue.tasks.pop_back();
+		return true;
+	}
+
+	std::vector<Queue> queues;
+};
+
+// Same result as `FlagTrueEquationsBackward`, spread across threads. An equation with n numbers costs up to 3^(n-1)
+// combinations, so the costs vary wildly: equations that are too big get split into subtrees by fixing their
+// first few operators, all tasks are handed out biggest first, and threads that run out steal from the others.
+void FlagTrueEquationsParallel(std::vector<Equation>& equations)
+{
+	unsigned threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 1;
+
+	// Equations with more operators than this get split up, so that tasks are around 3^8 combinations.
+	// Past 12 operators the split is capped, and tasks grow again rather than the task list exploding.
+	constexpr unsigned operatorsPerTask = 8;
+	constexpr unsigned maxPrefixLength = 4; // at most 81 tasks per equation
+
+	std::vector<EquationTask> tasks;
+	for (size_t i = 0; i < equations.size(); ++i)
+	{
+		const unsigned operatorCount = static_cast<unsigned>(equations[i].numbers.size() - 1);
+		const unsigned prefixLength = operatorCount > operatorsPerTask ? std::min(operatorCount - operatorsPerTask, maxPrefixLength) : 0;
+		const BigNumber cost = Pow(numOfOperatorTypes, operatorCount - prefixLength);
+
+		for (BigNumber prefix = 0; prefix < Pow(numOfOperatorTypes, prefixLength); ++prefix)
+			tasks.push_back({ i, prefixLength, prefix, cost });
+	}
+
+	std::stable_sort(tasks.begin(), tasks.end(), [](const EquationTask& a, const EquationTask& b)
+		{ return a.cost > b.cost; });
+
+	// Deal the tasks out round robin, so every thread starts on some of the biggest ones.
+	WorkStealingQueues queues(threadCount);
+	for (size_t i = 0; i < tasks.size(); ++i)
+		queues.Push(i % threadCount, tasks[i]);
+
+	std::vector<std::atomic<bool>> solved(equations.size());
+	for (std::atomic<bool>& flag : solved)
+		flag = false;
+
+	auto Work = [&](unsigned threadIndex)
+		{
+			std::vector<Operator> ops;
+			EquationTask task;
+			while (queues.Pop(threadIndex, task))
+			{
+				const Equation& equation = equations[task.equationIndex];
+				std::atomic<bool>& isSolved = solved[task.equationIndex];
+				if (isSolved.load(std::memory_order_relaxed))
+					continue;
+
+				// apply the operators this task starts with, then search the rest of the tree
+				ops.resize(task.prefixLength);
+				GenerateOperatorsFromCombination(ops, task.prefix);
+
+				BigNumber total = equation.numbers.front();
+				for (unsigned i = 0; i < ops.size(); ++i)
+				{
+					const BigNumber number = equation.numbers[i + 1];
+					switch (ops[i])
+					{
+					case Operator::ADD:      total = SaturatingAdd(total, number); break;
+					case Operator::MULTIPLY: total = SaturatingMultiply(total, number); break;
+					case Operator::CONCAT:   total = Concatenate(total, number); break;
+					default:                 break;
+					}
+				}
+
+				if (SearchForward(equation, ops.size() + 1, total, FirstIndexAfterLastZero(equation.numbers), isSolved))
+					isSolved = true;
+			}
+		};
+
+	std::vector<std::thread> workers;
+	for (unsigned i = 0; i < threadCount; ++i)
+		workers.emplace_back(Work, i);
+	for (std::thread& worker : workers)
+		worker.join();
+
+	for (size_t i = 0; i < equations.size(); ++i)
+		equations[i].isTrueEquation = solved[i];
+}
+
 bool ReadDataFromFile(const std::string& filename, std::vector<Equation>& equations)
 {
 	std::fstream file(filename);
@@ -216,7 +468,10 @@ int main(int argc, char* argv[])
 	if (!ReadDataFromFile(filename, equations))
 		return -1;
 
-	FlagTrueEquations(equations);
+	// FlagTrueEquations(equations);
+	// FlagTrueEquationsParallel(equations);
+	// FlagTrueEquationsBackward(equations, false); // part 1 (no concatenation)
+	FlagTrueEquationsBackward(equations);
 
 	BigNumber total = 0;
 